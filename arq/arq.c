@@ -0,0 +1,3091 @@
+#include <stdarg.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/* ******************************************************************
+   ARQ NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
+   MODIFIED by Chong Wang on Oct.21,2005 for csa2,csa3 environments
+
+   This code should be used for PA2, unidirectional data transfer protocols
+   (from A to B)
+   Network properties:
+   - one way network delay averages five time units (longer if there
+     are other messages in the channel for Pipelined ARQ), but can be larger
+   - packets can be corrupted (either the header or the data portion)
+     or lost, according to user-defined probabilities
+   - packets will be delivered in the order in which they were sent
+     (although some can be lost), unless the reorder parameter is set.
+**********************************************************************/
+
+/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
+/* 4 (students' code).  It contains the data (characters) to be delivered */
+/* to layer 5 via the students transport level protocol entities.         */
+/* Messages and payloads are the run's payload_size bytes long (20 by     */
+/* default), so both point into storage owned by whoever holds them.     */
+struct msg
+{
+  char *data;
+};
+
+/* a packet is the data unit passed from layer 4 (students code) to layer */
+/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
+/* students must follow. */
+struct pkt
+{
+  int seqnum;
+  int acknum;
+  int checksum;
+  char *payload; /* payload_size bytes */
+  int sack[5];   /* selectively ACKed seqnums, -1 for none (gbn-sack only) */
+};
+
+/* bytes of seqnum, acknum, checksum and sack[] on the wire; B's ACKs */
+/* are header only and carry no payload                               */
+#define HEADER_BYTES (8 * 4)
+
+/*- Your Definitions
+  ---------------------------------------------------------------------------*/
+
+/* Please use the following values in your program */
+
+#define A 0
+#define B 1
+#define FIRST_SEQNO 0
+
+/*- Declarations ------------------------------------------------------------*/
+
+/* One simulation run: its parameters, both entities and the emulator.  */
+/* Every routine takes the run it works on, so independent runs can go  */
+/* on side by side, e.g. one per thread.  Defined below the entities.   */
+struct sim;
+
+/* The routines that differ between the ARQ variants.  A_output, A_init */
+/* and the send buffer are shared; the run's protocol parameter picks   */
+/* one of protocols[] to handle everything else.                        */
+struct protocol
+{
+  const char *name; /* as given to --protocol and in the statistics */
+  void (*A_input)(struct sim *sim, struct pkt packet);
+  void (*A_timerinterrupt)(struct sim *sim);
+  void (*B_input)(struct sim *sim, struct pkt packet);
+  void (*B_init)(struct sim *sim);
+};
+
+struct sim *sim_create(void);
+void sim_start(struct sim *sim);
+void sim_run(struct sim *sim);
+void sim_destroy(struct sim *sim);
+
+void restart_rxmt_timer(struct sim *sim);
+void send_window(struct sim *sim);
+void tolayer3(struct sim *sim, int AorB, struct pkt packet);
+void tolayer5(struct sim *sim, char *datasent);
+void note_arrival(struct sim *sim, int msgno);
+int receiver_occupancy(struct sim *sim);
+void output_open(struct sim *sim, const char *path);
+void output_close(struct sim *sim);
+
+void starttimer(struct sim *sim, int AorB, double increment);
+void stoptimer(struct sim *sim, int AorB);
+
+void Simulation_done(struct sim *sim);
+
+/* structured statistics record, used when STATS_FORMAT is not STATS_TEXT */
+#define STATS_TEXT 0
+#define STATS_JSON 1
+#define STATS_CSV 2
+#define STATS_MAX_FIELDS 128
+
+#define CHECKSUM_CRC32C 0 /* CRC32C over the header and payload */
+#define CHECKSUM_SUM 1    /* the original sum of seqnum, acknum and payload */
+
+#define RNG_LEGACY 0 /* the original LCG, one per seed[i] */
+#define RNG_PHILOX 1 /* Philox4x32-10, counter-based */
+#define RNG_STREAMS 8 /* arrivals, loss, delay, corruption, its kind, loss state, RED, reordering */
+#ifndef RNG_BLOCK
+#define RNG_BLOCK 64 /* draws generated at a time per stream, even */
+#endif
+
+#define LOSS_BERNOULLI 0 /* every packet lost with lossprob */
+#define LOSS_GILBERT 1   /* Gilbert-Elliott: loss depends on a good/bad state */
+
+#define LINK_RANDOM 0     /* the original: 1 to 10 after the last packet in flight */
+#define LINK_BOTTLENECK 1 /* bandwidth, propagation delay and a finite queue */
+
+#define AQM_DROPTAIL 0 /* drop arrivals to a full queue */
+#define AQM_RED 1      /* random early detection on the average queue length */
+extern const char *const link_models[]; /* indexed by link_model */
+extern const char *const aqms[];        /* indexed by aqm */
+
+#define OUTPUT_BUFFERED 0 /* OutputFile written from a userspace buffer */
+#define OUTPUT_MMAP 1     /* OutputFile mapped and written in place */
+#define OUTPUT_DISCARD 2  /* no OutputFile */
+
+struct stats_field
+{
+  const char *name;
+  char value[40];
+};
+
+void stats_begin(struct sim *sim, const char *protocol);
+void stats_int(struct sim *sim, const char *name, long value);
+void stats_string(struct sim *sim, const char *name, const char *value);
+void stats_double(struct sim *sim, const char *name, double value);
+void stats_end(struct sim *sim);
+
+/* sim->WINDOW_SIZE, sim->RXMT_TIMEOUT and sim->TRACE are inputs to the
+   program; Please set an appropriate value for sim->LIMIT_SEQNO.
+   You have to use these variables in your
+   routines --------------------------------------------------------------*/
+
+/********* YOU MAY ADD SOME ROUTINES HERE ********/
+
+/* Payloads are not NUL-terminated, so trace points print them as %.*s
+   with TRACE_BYTES(sim), at most 20 bytes, as the precision. */
+#define TRACE_BYTES(sim) ((sim)->payload_size < 20 ? (sim)->payload_size : 20)
+
+/* Protocol trace points, for routines with the run in scope as sim.
+   PTRACE prints when sim->TRACE >= 1.  Building with
+   -DNTRACE compiles every trace point out; building with -DTRACE_RING=<n>
+   instead records the last n trace points unformatted in memory, and they
+   are decoded into TraceRing when the simulation ends. */
+#if defined(NTRACE)
+#define PTRACE_ENABLED 0
+#define PTRACE(...) ((void)0)
+#elif defined(TRACE_RING)
+#define PTRACE_ENABLED 1
+#define PTRACE(...) trace_ring_put(sim, __VA_ARGS__)
+#else
+#define PTRACE_ENABLED (sim->TRACE >= 1)
+#define PTRACE(...)          \
+  do                         \
+  {                          \
+    if (PTRACE_ENABLED)      \
+      printf(__VA_ARGS__);   \
+  } while (0)
+#endif
+
+#if defined(TRACE_RING) && !defined(NTRACE)
+#define TRACE_RING_ARGS 3
+
+struct trace_record
+{
+  double time;
+  const char *fmt; // format strings are literals, so the pointer stays valid
+  union
+  {
+    long i;
+    double f;
+  } args[TRACE_RING_ARGS];
+  char str[24]; // first %s argument, truncated
+};
+#endif
+
+
+/* The send buffer starts at SNDBUF_INIT slots (at least one window) and
+   doubles whenever it is full, up to SNDBUF_MAX slots.  Once it is at the
+   cap, further layer-5 messages wait in the backlog until the window moves
+   on, or the run aborts as it used to if BACKPRESSURE is 0. */
+#ifndef SNDBUF_INIT
+#define SNDBUF_INIT 64
+#endif
+#ifndef SNDBUF_MAX
+#define SNDBUF_MAX 4096
+#endif
+#ifndef BACKPRESSURE
+#define BACKPRESSURE 1
+#endif
+
+/* window buffers are power-of-two rings indexed by (i & mask); a presence
+   bitmap records which slots hold a packet */
+#define BITMAP_WORDS(size) (((size) + 63) / 64)
+
+bool slot_present(const uint64_t *bitmap, int mask, int i)
+{
+  i &= mask;
+  return (bitmap[i / 64] >> (i % 64)) & 1;
+}
+
+void set_slot(uint64_t *bitmap, int mask, int i)
+{
+  i &= mask;
+  bitmap[i / 64] |= (uint64_t)1 << (i % 64);
+}
+
+void clear_slot(uint64_t *bitmap, int mask, int i)
+{
+  i &= mask;
+  bitmap[i / 64] &= ~((uint64_t)1 << (i % 64));
+}
+
+int round_up_pow2(int n)
+{
+  int size = 1;
+  while (size < n)
+    size *= 2;
+  return size;
+}
+
+void *alloc_or_die(size_t count, size_t size)
+{
+  void *p = calloc(count, size);
+  if (p == NULL)
+  {
+    printf("  alloc_or_die: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+/* a ring of slots packets whose payloads live in one block of storage */
+struct pkt *alloc_packets(int slots, int payload_size, char **payloads)
+{
+  struct pkt *packets = alloc_or_die(slots, sizeof(struct pkt));
+  *payloads = alloc_or_die(slots, payload_size);
+  for (int i = 0; i < slots; i++)
+    packets[i].payload = *payloads + (size_t)i * payload_size;
+  return packets;
+}
+
+// simulated times of a buffered packet, for latency accounting
+struct send_times
+{
+  double submitted;  // message handed down by layer 5
+  double first_sent; // first transmission
+};
+
+// A
+struct Sender
+{
+  int window_start;
+  int send_next;
+  int buffer_next;
+  int last_ack;
+  int mask; // buffer size - 1
+  struct pkt *packet_buffer;
+  char *payloads; // payload storage of packet_buffer
+  uint64_t *present;
+  struct send_times *send_times;
+  int *retransmissions;
+};
+
+// Layer-5 messages waiting for room in the send buffer
+struct Backlog
+{
+  int head;
+  int count;
+  int mask;
+  char *messages; // payload_size bytes each
+  double *queued_at;
+};
+
+// B
+struct Receiver
+{
+  int window_start;
+  struct pkt ack_pkt;
+  int mask; // buffer size - 1, sr only
+  struct pkt *packet_buffer;
+  char *payloads; // payload storage of packet_buffer
+  uint64_t *present;
+};
+
+
+/* Log-bucketed histogram in the style of HdrHistogram: values are counted
+   in multiples of unit, exactly below HIST_SUB units and with HIST_SUB/2
+   buckets per power of two above that, so any percentile is reported to
+   within about 3% of the true value. */
+#define HIST_SUB_BITS 6
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB / 2)
+
+struct histogram
+{
+  double unit;
+  long count;
+  double max;
+  long buckets[HIST_BUCKETS];
+};
+
+int hist_bucket(uint64_t v)
+{
+  if (v < HIST_SUB)
+    return (int)v;
+  int shift = 63 - __builtin_clzll(v) - (HIST_SUB_BITS - 1);
+  int bucket = shift * (HIST_SUB / 2) + (int)(v >> shift);
+  return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+/* largest value, in units, counted by the bucket */
+uint64_t hist_bucket_top(int bucket)
+{
+  if (bucket < HIST_SUB)
+    return bucket;
+  int shift = bucket / (HIST_SUB / 2) - 1;
+  uint64_t sub = bucket - shift * (HIST_SUB / 2);
+  return ((sub + 1) << shift) - 1;
+}
+
+void hist_record(struct histogram *h, double value)
+{
+  double units = value / h->unit;
+  h->buckets[hist_bucket(units > 0 ? (uint64_t)units : 0)]++;
+  if (h->count == 0 || value > h->max)
+    h->max = value;
+  h->count++;
+}
+
+/* value at or below which a fraction q of the samples fall (NAN if empty) */
+double hist_percentile(const struct histogram *h, double q)
+{
+  if (h->count == 0)
+    return NAN;
+  long rank = (long)(q * h->count);
+  if (rank < q * h->count)
+    rank++;
+  long seen = 0;
+  for (int b = 0; b < HIST_BUCKETS; b++)
+  {
+    seen += h->buckets[b];
+    if (seen >= rank && seen > 0)
+    {
+      double top = hist_bucket_top(b) * h->unit;
+      return top < h->max ? top : h->max;
+    }
+  }
+  return h->max;
+}
+
+/* Delivery check: with the verify parameter set, every message delivered
+   at B is matched against the messages generated by sim_run(), where
+   message k is the letter 'a' + k % 26 repeated up to a final newline.  A
+   delivery is taken to be the message with its letter nearest to the
+   lowest one not yet delivered, and counted as in order, reordered, a
+   duplicate or malformed; messages passed over and never delivered are
+   gaps.  Nothing is written, so large sweeps can check every run. */
+struct verifier
+{
+  uint64_t *delivered;  /* bitmap over message indices */
+  int size;             /* messages covered by the bitmap */
+  int next;             /* lowest message not yet delivered */
+  int highest;          /* highest message delivered, -1 if none */
+  long deliveries;
+  int in_order;
+  int reordered;
+  int duplicates;
+  int malformed;
+  long first_divergence; /* delivery number, from 0, or -1 if none */
+  int divergence_expected; /* message index expected there */
+  char divergence_got;     /* first character delivered there */
+};
+
+bool verify_seen(const struct verifier *v, int k)
+{
+  return (v->delivered[k / 64] >> (k % 64)) & 1;
+}
+
+void verify_delivery(struct verifier *v, const char *data, int size)
+{
+  long n = v->deliveries++;
+  int base = v->next - 13;
+  int k = base + ((data[0] - 'a' - base) % 26 + 26) % 26;
+  bool wellformed = data[0] >= 'a' && data[0] <= 'z' && data[size - 1] == '\n';
+  for (int i = 1; wellformed && i < size - 1; i++)
+    wellformed = data[i] == data[0];
+  if (k < 0)
+    k += 26;
+
+  if (!wellformed || k >= v->size)
+    v->malformed++;
+  else if (verify_seen(v, k))
+    v->duplicates++;
+  else
+  {
+    v->delivered[k / 64] |= (uint64_t)1 << (k % 64);
+    if (k > v->highest)
+      v->highest = k;
+    if (k == v->next)
+    {
+      v->in_order++;
+      while (v->next < v->size && verify_seen(v, v->next))
+        v->next++;
+      return;
+    }
+    v->reordered++;
+  }
+  if (v->first_divergence < 0)
+  {
+    v->first_divergence = n;
+    v->divergence_expected = v->next;
+    v->divergence_got = data[0];
+  }
+}
+
+/* messages passed over by a later delivery and never delivered */
+int verify_gaps(const struct verifier *v)
+{
+  int gaps = 0;
+  for (int k = v->next; k < v->highest; k++)
+    if (!verify_seen(v, k))
+      gaps++;
+  return gaps;
+}
+
+/* Bottleneck link: one direction of the channel with the bandwidth
+   and propagation delay parameters.  Packets wait in a FIFO of queue
+   packets, the one being serialized included, and one arriving to a
+   full queue (or one RED picks) is dropped.  depart[] holds the times
+   the queued packets finish serialization, oldest first. */
+struct link
+{
+  double *depart;   /* ring of queue entries */
+  int head;         /* oldest entry in depart[] */
+  int count;        /* packets queued, as of the last arrival */
+  double red_avg;   /* RED: moving average of count */
+  int red_count;    /* RED: packets accepted since the last drop, -1 below red_min */
+  int peak;         /* longest queue seen by an arrival */
+  int sent;         /* packets accepted */
+  int drops;        /* packets dropped by the queue */
+  double queue_delay_sum;
+  double queue_delay_max;
+  double serialization_sum;
+};
+
+/* a per-packet average of sum over the packets the link accepted */
+double link_average(const struct link *l, double sum)
+{
+  return l->sent ? sum / l->sent : 0.0;
+}
+
+/* the fields keep the names of the globals they replace */
+struct sim
+{
+  /* parameters */
+  const struct protocol *protocol;
+  int protocol_index;   // into protocols[]
+  int WINDOW_SIZE;      // size of the window
+  int LIMIT_SEQNO;      // when sequence number reaches this value, it wraps around
+  double RXMT_TIMEOUT;  // retransmission timeout
+  int TRACE;            // trace level, for your debug purpose
+  int STATS_FORMAT;     // STATS_TEXT, STATS_JSON or STATS_CSV
+  int OUTPUT_MODE;      // OUTPUT_BUFFERED, OUTPUT_MMAP or OUTPUT_DISCARD
+  double lossprob;      /* probability that a packet is dropped  */
+  double corruptprob;   /* probability that one bit is packet is flipped */
+  double lambda;        /* arrival rate of messages from layer 5 */
+  int nsimmax;          /* number of messages to simulate */
+  unsigned int seed[RNG_STREAMS]; /* seed used in the pseudo-random generator */
+  int seed_param;       /* seed as given, for the statistics record */
+  int rng_type;         /* RNG_LEGACY or RNG_PHILOX */
+  uint64_t rng_draws[RNG_STREAMS];    /* Philox: draws taken from each stream so far */
+  uint32_t rng_block[RNG_STREAMS][4]; /* Philox: the block the last draw came from */
+  double rng_buf[RNG_STREAMS][RNG_BLOCK]; /* draws generated ahead for mrand() */
+  int rng_next[RNG_STREAMS];          /* next unused draw in rng_buf[i] */
+  int loss_model;       /* LOSS_BERNOULLI or LOSS_GILBERT */
+  double ge_to_bad;     /* Gilbert-Elliott: P(good -> bad) per packet */
+  double ge_to_good;    /* P(bad -> good) per packet */
+  double ge_loss_good;  /* loss probability in the good state */
+  double ge_loss_bad;   /* loss probability in the bad state */
+  int link_model;       /* LINK_RANDOM or LINK_BOTTLENECK */
+  double bandwidth;     /* bottleneck: bytes per time unit */
+  double prop_delay;    /* bottleneck: propagation delay */
+  int queue_size;       /* bottleneck: queue capacity in packets */
+  int aqm;              /* AQM_DROPTAIL or AQM_RED */
+  double red_min;       /* RED: average queue length where early drops start */
+  double red_max;       /* RED: average queue length where every arrival drops */
+  double red_maxp;      /* RED: drop probability at red_max */
+  double red_weight;    /* RED: weight of each arrival in the average */
+  double reorder;       /* probability that a packet is held back */
+  int reorder_depth;    /* later packets that overtake a held packet */
+  int sndbuf_max;
+  int backpressure;
+  int verify;           /* check deliveries in a struct verifier */
+  int payload_size;     /* bytes per message and data packet */
+  int checksum_type;    /* CHECKSUM_CRC32C or CHECKSUM_SUM */
+  uint32_t (*crc32c)(uint32_t crc, const void *data, size_t len); /* picked for the CPU */
+
+  /* entities */
+  struct Sender A_ent;
+  struct Backlog backlog;
+  struct Receiver B_ent;
+#if defined(TRACE_RING) && !defined(NTRACE)
+  struct trace_record trace_ring[TRACE_RING];
+  unsigned long trace_ring_next;
+#endif
+
+  /* statistics */
+  int num_original_transmitted;
+  int num_retransmissions;
+  int num_delivered;
+  int num_ack_sent;
+  int num_ack_received;
+  int num_corrupted;
+  double rtt_sum;
+  int rtt_count;
+  double comm_time_sum;
+  int comm_time_count;
+  double completion_time_sum;
+  struct histogram rtt_hist;
+  struct histogram e2e_hist;
+  struct histogram retx_hist;
+  struct histogram rcvbuf_hist; /* packets buffered at B after each arrival */
+  struct verifier verifier;
+  int num_backlogged;
+  int backlog_peak;
+  double backlog_delay_sum;
+  double backlog_delay_max;
+
+  /* emulator */
+  double time_now; // simulation time, for your debug purpose
+  char *msgbuf;    /* the message being handed to layer 4 */
+  long nbytes[2];  /* bytes sent into layer 3 by A and by B */
+  int fileoutput;  /* layer-5 output at B, or -1 for none */
+  char *outbuf;    /* pending layer-5 output, or the mapped OutputFile */
+  size_t outbuf_used;
+  size_t outbuf_size;
+  int ntolayer3;   /* number sent into layer 3 */
+  int nlost;       /* number lost in media */
+  int ncorrupt;    /* number corrupted by media*/
+  int nbursts;     /* runs of consecutive losses in one direction */
+  bool last_lost[2]; /* whether the last packet A or B sent was lost */
+  bool ge_bad[2];  /* Gilbert-Elliott state of the channel from A or B */
+  struct link link[2]; /* bottleneck link from A or B */
+  struct event *reorder_held[2]; /* packet from A or B being held back, if any */
+  double reorder_until[2]; /* when that packet arrives if nothing overtakes it */
+  int reorder_left[2];  /* packets still to overtake it */
+  int nheld;            /* packets held back */
+  int nreordered;       /* held packets overtaken by reorder_depth others */
+  uint64_t *arrived;    /* messages whose data has reached B intact */
+  int arrived_size;     /* messages covered by the bitmap */
+  int nspurious;        /* data packets reaching B intact a second time or more */
+  int nbad;        /* packets sent while their channel was bad */
+  int nsim;
+  /* the event list: a binary min-heap ordered by evtime.  Events with equal */
+  /* evtime pop most-recently-inserted first, which is the order the old    */
+  /* sorted linked list produced, so runs stay identical for a given seed.  */
+  struct event **evlist;
+  int evcount;
+  int evcapacity;
+  unsigned long evseq_next;
+  struct event *evpool_free;
+  struct event **evpool_slab_list;
+  int evpool_slabs;
+  int evpool_inuse;
+  int evpool_peak;
+  /* the pending timer event of each entity, or NULL if its timer is not */
+  /* running.  stoptimer() only marks the event cancelled, so timers can  */
+  /* be started and stopped without searching the event list.            */
+  struct event *timers[2];
+  /* latest arrival time scheduled by tolayer3() towards each entity.  Once */
+  /* it is in the past the channel towards that entity is empty.            */
+  double channel_tail[2];
+  struct stats_field stats_fields[STATS_MAX_FIELDS];
+  int stats_nfields;
+};
+
+#if defined(TRACE_RING) && !defined(NTRACE)
+/* skip to the conversion character of the % directive at p */
+const char *trace_conversion(const char *p)
+{
+  return p + 1 + strspn(p + 1, "-+ #0123456789.*hlz");
+}
+
+void trace_ring_put(struct sim *sim, const char *fmt, ...)
+{
+  struct trace_record *rec = &sim->trace_ring[sim->trace_ring_next++ % TRACE_RING];
+  int n = 0;
+  bool have_str = false;
+  va_list ap;
+
+  rec->time = sim->time_now;
+  rec->fmt = fmt;
+  rec->str[0] = '\0';
+  va_start(ap, fmt);
+  for (const char *p = strchr(fmt, '%'); p != NULL; p = strchr(p + 1, '%'))
+  {
+    const char *directive = p;
+    int precision = -1;
+    p = trace_conversion(p);
+    if (*p == '%')
+      continue;
+    for (const char *q = directive; q < p; q++)
+      if (*q == '.')
+        precision = q[1] == '*' ? va_arg(ap, int) : atoi(q + 1);
+    if (*p == 's')
+    {
+      const char *s = va_arg(ap, const char *);
+      if (!have_str)
+      {
+        /* payloads are not terminated, so read no further than the precision */
+        size_t max = sizeof(rec->str) - 1;
+        if (precision >= 0 && (size_t)precision < max)
+          max = precision;
+        size_t len = strnlen(s, max);
+        memcpy(rec->str, s, len);
+        rec->str[len] = '\0';
+        have_str = true;
+      }
+    }
+    else if (*p == 'f')
+    {
+      double f = va_arg(ap, double);
+      if (n < TRACE_RING_ARGS)
+        rec->args[n++].f = f;
+    }
+    else
+    {
+      long i = p[-1] == 'l' ? va_arg(ap, long) : va_arg(ap, int);
+      if (n < TRACE_RING_ARGS)
+        rec->args[n++].i = i;
+    }
+  }
+  va_end(ap);
+}
+
+/* format the recorded trace points, oldest first */
+void trace_ring_dump(struct sim *sim, FILE *out)
+{
+  unsigned long first = sim->trace_ring_next > TRACE_RING ? sim->trace_ring_next - TRACE_RING : 0;
+  bool line_start = true;
+  for (unsigned long k = first; k < sim->trace_ring_next; k++)
+  {
+    struct trace_record *rec = &sim->trace_ring[k % TRACE_RING];
+    const char *p = rec->fmt;
+    int n = 0;
+    if (line_start)
+      fprintf(out, "[%.6f]", rec->time);
+    line_start = p[0] != '\0' && p[strlen(p) - 1] == '\n';
+    while (*p)
+    {
+      const char *end;
+      char spec[16];
+      if (*p != '%')
+      {
+        fputc(*p++, out);
+        continue;
+      }
+      end = trace_conversion(p);
+      if (*end == '\0' || end - p + 1 >= (int)sizeof(spec))
+        break;
+      memcpy(spec, p, end - p + 1);
+      spec[end - p + 1] = '\0';
+      if (*end == '%')
+        fputc('%', out);
+      else if (*end == 's' && strchr(spec, '*') != NULL)
+        fprintf(out, spec, (int)strlen(rec->str), rec->str); /* cut to the precision when recorded */
+      else if (*end == 's')
+        fprintf(out, spec, rec->str);
+      else if (*end == 'f')
+        fprintf(out, spec, n < TRACE_RING_ARGS ? rec->args[n++].f : 0.0);
+      else if (end[-1] == 'l')
+        fprintf(out, spec, n < TRACE_RING_ARGS ? rec->args[n++].i : 0L);
+      else
+        fprintf(out, spec, n < TRACE_RING_ARGS ? (int)rec->args[n++].i : 0);
+      p = end + 1;
+    }
+  }
+}
+#endif
+
+const double hist_quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+void hist_print(const char *label, const struct histogram *h)
+{
+  printf("%s p50/p90/p99/p99.9/max:", label);
+  for (int q = 0; q < 4; q++)
+    printf(" %.3f", hist_percentile(h, hist_quantiles[q]));
+  printf(" %.3f \n", h->count ? h->max : NAN);
+}
+
+/* names holds the field names for p50, p90, p99, p99.9 and max; the
+   statistics record keeps the pointers, so they must be literals */
+void hist_stats(struct sim *sim, const char *const names[5], const struct histogram *h)
+{
+  for (int q = 0; q < 4; q++)
+    stats_double(sim, names[q], hist_percentile(h, hist_quantiles[q]));
+  stats_double(sim, names[4], h->count ? h->max : NAN);
+}
+
+/* End-to-end delay of the packet with send index i, delivered to layer 5 at
+   B now.  Both entities live in this process, so B can look up the time A
+   took the message from layer 5; A cannot release that slot before this
+   delivery is ACKed. */
+void record_delivery(struct sim *sim, int i)
+{
+  hist_record(&sim->e2e_hist, sim->time_now - sim->A_ent.send_times[i & sim->A_ent.mask].submitted);
+}
+
+/* CRC32C (Castagnoli, reflected, as in iSCSI and SCTP).  crc32c_hw uses
+   the CPU's CRC32 instruction eight bytes at a time; crc32c_sw is the
+   table-driven fallback, and sim_start() picks one for the run. */
+static const uint32_t crc32c_table[256] = {
+    0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+    0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+    0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+    0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+    0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+    0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+    0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+    0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+    0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+    0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+    0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+    0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+    0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+    0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+    0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+    0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+    0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+    0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+    0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+    0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+    0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+    0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+    0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+    0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+    0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+    0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+    0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+    0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+    0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+    0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+    0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+    0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+    0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+    0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+    0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+    0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+    0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+    0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+    0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+    0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+    0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+    0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+    0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351};
+
+uint32_t crc32c_sw(uint32_t crc, const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  while (len--)
+    crc = crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t crc32c_hw(uint32_t crc, const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  uint64_t crc64 = crc;
+  for (; len >= 8; p += 8, len -= 8)
+  {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = (uint32_t)crc64;
+  while (len--)
+    crc = _mm_crc32_u8(crc, *p++);
+  return crc;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t crc32c_hw(uint32_t crc, const void *data, size_t len)
+{
+  const unsigned char *p = data;
+  for (; len >= 8; p += 8, len -= 8)
+  {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    crc = __crc32cd(crc, word);
+  }
+  while (len--)
+    crc = __crc32cb(crc, *p++);
+  return crc;
+}
+#endif
+
+/* the CRC32C routine for this CPU */
+uint32_t (*crc32c_select(void))(uint32_t, const void *, size_t)
+{
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("sse4.2"))
+    return crc32c_hw;
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+  return crc32c_hw;
+#endif
+  return crc32c_sw;
+}
+
+/* CRC32C of everything in the packet but the checksum itself, so a
+   corrupted SACK is caught too; or the original byte sum if selected.
+   payload_len is payload_size for data packets and 0 for ACKs, which
+   are header only */
+int get_checksum(struct sim *sim, struct pkt packet, int payload_len)
+{
+  if (sim->checksum_type == CHECKSUM_SUM)
+  {
+    int checksum = 0;
+    checksum += packet.seqnum;
+    checksum += packet.acknum;
+    for (int i = 0; i < payload_len; i++)
+    {
+      checksum += packet.payload[i];
+    }
+    return checksum;
+  }
+  int32_t header[7] = {packet.seqnum, packet.acknum, packet.sack[0], packet.sack[1],
+                       packet.sack[2], packet.sack[3], packet.sack[4]};
+  uint32_t crc = sim->crc32c(~0u, header, sizeof(header));
+  crc = sim->crc32c(crc, packet.payload, payload_len);
+  return (int)~crc;
+}
+
+/* true if an ACK for acknum names a send index in [window_start,
+   send_next].  A reordering channel delivers ACKs from behind the
+   window, which must not move it: every later index would match none
+   of them and be released as ACKed. */
+bool ack_in_window(struct sim *sim, int acknum)
+{
+  int d = ((acknum - sim->A_ent.window_start) % sim->LIMIT_SEQNO + sim->LIMIT_SEQNO) % sim->LIMIT_SEQNO;
+  return acknum >= 0 && acknum < sim->LIMIT_SEQNO && d <= sim->A_ent.send_next - sim->A_ent.window_start;
+}
+
+bool send_buffer_full(struct sim *sim)
+{
+  return sim->A_ent.buffer_next - sim->A_ent.window_start > sim->A_ent.mask;
+}
+
+/* double the send buffer, re-homing the buffered packets; false at the cap */
+bool grow_send_buffer(struct sim *sim)
+{
+  int size = (sim->A_ent.mask + 1) * 2;
+  if (size > sim->sndbuf_max)
+    return false;
+
+  int mask = size - 1;
+  char *payloads;
+  struct pkt *packet_buffer = alloc_packets(size, sim->payload_size, &payloads);
+  uint64_t *present = alloc_or_die(BITMAP_WORDS(size), sizeof(uint64_t));
+  struct send_times *send_times = alloc_or_die(size, sizeof(struct send_times));
+  int *retransmissions = alloc_or_die(size, sizeof(int));
+  for (int i = sim->A_ent.window_start; i < sim->A_ent.buffer_next; i++)
+  {
+    if (!slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+      continue;
+    char *payload = packet_buffer[i & mask].payload;
+    packet_buffer[i & mask] = sim->A_ent.packet_buffer[i & sim->A_ent.mask];
+    packet_buffer[i & mask].payload = payload;
+    memcpy(payload, sim->A_ent.packet_buffer[i & sim->A_ent.mask].payload, sim->payload_size);
+    send_times[i & mask] = sim->A_ent.send_times[i & sim->A_ent.mask];
+    retransmissions[i & mask] = sim->A_ent.retransmissions[i & sim->A_ent.mask];
+    set_slot(present, mask, i);
+  }
+  free(sim->A_ent.packet_buffer);
+  free(sim->A_ent.payloads);
+  free(sim->A_ent.present);
+  free(sim->A_ent.send_times);
+  free(sim->A_ent.retransmissions);
+  sim->A_ent.packet_buffer = packet_buffer;
+  sim->A_ent.payloads = payloads;
+  sim->A_ent.present = present;
+  sim->A_ent.send_times = send_times;
+  sim->A_ent.retransmissions = retransmissions;
+  sim->A_ent.mask = mask;
+  PTRACE("  grow_send_buffer: send buffer grown to %d slots\n", size);
+  return true;
+}
+
+void enqueue_backlog(struct sim *sim, struct msg message)
+{
+  if (sim->backlog.count > sim->backlog.mask)
+  {
+    int size = (sim->backlog.mask + 1) * 2;
+    char *messages = alloc_or_die(size, sim->payload_size);
+    double *queued_at = alloc_or_die(size, sizeof(double));
+    for (int i = 0; i < sim->backlog.count; i++)
+    {
+      memcpy(messages + (size_t)i * sim->payload_size,
+             sim->backlog.messages + (size_t)((sim->backlog.head + i) & sim->backlog.mask) * sim->payload_size,
+             sim->payload_size);
+      queued_at[i] = sim->backlog.queued_at[(sim->backlog.head + i) & sim->backlog.mask];
+    }
+    free(sim->backlog.messages);
+    free(sim->backlog.queued_at);
+    sim->backlog.messages = messages;
+    sim->backlog.queued_at = queued_at;
+    sim->backlog.head = 0;
+    sim->backlog.mask = size - 1;
+  }
+  int tail = (sim->backlog.head + sim->backlog.count) & sim->backlog.mask;
+  memcpy(sim->backlog.messages + (size_t)tail * sim->payload_size, message.data, sim->payload_size);
+  sim->backlog.queued_at[tail] = sim->time_now;
+  sim->backlog.count++;
+  sim->num_backlogged++;
+  if (sim->backlog.count > sim->backlog_peak)
+    sim->backlog_peak = sim->backlog.count;
+  PTRACE("  A_output: send buffer full, queue message (backlog=%d)\n", sim->backlog.count);
+}
+
+/* turn a layer-5 message into the next packet of the send buffer */
+void buffer_message(struct sim *sim, struct msg message, double submitted)
+{
+  PTRACE("  A_output: buffer packet (seq=%d): %.*s\n",
+         sim->A_ent.buffer_next % sim->LIMIT_SEQNO, TRACE_BYTES(sim), message.data);
+  struct pkt *packet = &sim->A_ent.packet_buffer[sim->A_ent.buffer_next & sim->A_ent.mask];
+  packet->seqnum = sim->A_ent.buffer_next % sim->LIMIT_SEQNO;
+  memmove(packet->payload, message.data, sim->payload_size);
+  packet->checksum = get_checksum(sim, *packet, sim->payload_size);
+  sim->A_ent.send_times[sim->A_ent.buffer_next & sim->A_ent.mask].submitted = submitted;
+  set_slot(sim->A_ent.present, sim->A_ent.mask, sim->A_ent.buffer_next);
+  sim->A_ent.buffer_next++;
+}
+
+/* move backlogged messages into the send buffer as far as it has room */
+void drain_backlog(struct sim *sim)
+{
+  while (sim->backlog.count > 0 && !send_buffer_full(sim))
+  {
+    double delay = sim->time_now - sim->backlog.queued_at[sim->backlog.head];
+    sim->backlog_delay_sum += delay;
+    if (delay > sim->backlog_delay_max)
+      sim->backlog_delay_max = delay;
+    struct msg message = {sim->backlog.messages + (size_t)sim->backlog.head * sim->payload_size};
+    buffer_message(sim, message, sim->backlog.queued_at[sim->backlog.head]);
+    sim->backlog.head = (sim->backlog.head + 1) & sim->backlog.mask;
+    sim->backlog.count--;
+  }
+}
+
+void send_window(struct sim *sim)
+{
+  if (sim->A_ent.send_next == sim->A_ent.buffer_next || sim->A_ent.send_next == sim->A_ent.window_start + sim->WINDOW_SIZE)
+    return;
+
+  restart_rxmt_timer(sim);
+
+  while (sim->A_ent.send_next < sim->A_ent.buffer_next && sim->A_ent.send_next < sim->A_ent.window_start + sim->WINDOW_SIZE)
+  {
+    struct pkt *packet = &sim->A_ent.packet_buffer[sim->A_ent.send_next & sim->A_ent.mask];
+    sim->A_ent.send_times[sim->A_ent.send_next & sim->A_ent.mask].first_sent = sim->time_now;
+    PTRACE("  send_window: send packet (seq=%d): %.*s\n",
+           packet->seqnum, TRACE_BYTES(sim), packet->payload);
+    tolayer3(sim, A, *packet);
+    sim->num_original_transmitted++;
+    sim->A_ent.send_next++;
+  }
+}
+
+void send_ack(struct sim *sim)
+{
+  int acknum = sim->B_ent.window_start % sim->LIMIT_SEQNO;
+  sim->B_ent.ack_pkt.acknum = acknum;
+  sim->B_ent.ack_pkt.checksum = get_checksum(sim, sim->B_ent.ack_pkt, 0);
+  PTRACE("  send_ack: send ACK (ack=%d)\n", acknum);
+  tolayer3(sim, B, sim->B_ent.ack_pkt);
+  sim->num_ack_sent++;
+}
+
+/* Latency accounting, in simulated time.  Each send buffer slot remembers */
+/* when its message came down from layer 5 and when it was first sent.     */
+/* When the packet is finally ACKed, cumulatively or selectively:          */
+/*   communication time = ACK arrival - first transmission                 */
+/*   RTT = the same, for packets never retransmitted (Karn's rule)         */
+/*   completion time = ACK arrival - hand-down from layer 5                */
+void record_time_measurement(struct sim *sim, int i)
+{
+  struct send_times *times = &sim->A_ent.send_times[i & sim->A_ent.mask];
+  double measurement_time = sim->time_now - times->first_sent;
+
+  sim->comm_time_sum += measurement_time;
+  sim->comm_time_count++;
+  if (sim->A_ent.retransmissions[i & sim->A_ent.mask] == 0)
+  {
+    sim->rtt_sum += measurement_time;
+    sim->rtt_count++;
+    hist_record(&sim->rtt_hist, measurement_time);
+  }
+  hist_record(&sim->retx_hist, sim->A_ent.retransmissions[i & sim->A_ent.mask]);
+  sim->A_ent.retransmissions[i & sim->A_ent.mask] = 0;
+  sim->completion_time_sum += sim->time_now - times->submitted;
+}
+
+/********* ROUTINES SHARED BY ALL PROTOCOLS *********/
+
+/* called from layer 5, passed the data to be sent to other side */
+void A_output(struct sim *sim, struct msg message)
+{
+  // Keep layer-5 order: once messages are queued, new ones queue behind them
+  if (sim->backlog.count > 0 || (send_buffer_full(sim) && !grow_send_buffer(sim)))
+  {
+    if (!sim->backpressure)
+    {
+      printf("  A_output: buffer full\n");
+      Simulation_done(sim);
+      output_close(sim);
+      exit(1);
+    }
+    enqueue_backlog(sim, message);
+    return;
+  }
+  buffer_message(sim, message, sim->time_now);
+  send_window(sim);
+}
+
+/* the following routine will be called once (only) before any other */
+/* entity A routines are called. You can use it to do any initialization */
+void A_init(struct sim *sim)
+{
+  sim->A_ent.window_start = FIRST_SEQNO;
+  sim->A_ent.send_next = FIRST_SEQNO;
+  sim->A_ent.buffer_next = FIRST_SEQNO;
+  int size = round_up_pow2(sim->WINDOW_SIZE > SNDBUF_INIT ? sim->WINDOW_SIZE : SNDBUF_INIT);
+  if (sim->sndbuf_max < size)
+    sim->sndbuf_max = size;
+  sim->A_ent.mask = size - 1;
+  sim->A_ent.packet_buffer = alloc_packets(size, sim->payload_size, &sim->A_ent.payloads);
+  sim->A_ent.present = alloc_or_die(BITMAP_WORDS(size), sizeof(uint64_t));
+  sim->A_ent.send_times = alloc_or_die(size, sizeof(struct send_times));
+  sim->A_ent.retransmissions = alloc_or_die(size, sizeof(int));
+  sim->backlog.head = 0;
+  sim->backlog.count = 0;
+  sim->backlog.mask = 15;
+  sim->backlog.messages = alloc_or_die(sim->backlog.mask + 1, sim->payload_size);
+  sim->backlog.queued_at = alloc_or_die(sim->backlog.mask + 1, sizeof(double));
+  sim->A_ent.last_ack = -1;
+}
+
+/* release what A_init and the protocol's B_init allocated */
+void free_entities(struct sim *sim)
+{
+  free(sim->A_ent.packet_buffer);
+  free(sim->A_ent.payloads);
+  free(sim->A_ent.present);
+  free(sim->A_ent.send_times);
+  free(sim->A_ent.retransmissions);
+  free(sim->backlog.messages);
+  free(sim->backlog.queued_at);
+  free(sim->B_ent.ack_pkt.payload);
+  free(sim->B_ent.packet_buffer);
+  free(sim->B_ent.payloads);
+  free(sim->B_ent.present);
+}
+
+void restart_rxmt_timer(struct sim *sim)
+{
+  stoptimer(sim, A);
+  starttimer(sim, A, sim->RXMT_TIMEOUT);
+}
+
+/* called at end of simulation to print final statistics */
+void Simulation_done(struct sim *sim)
+{
+  double lost_ratio = (double)(sim->num_retransmissions - sim->num_corrupted) /
+                      (sim->num_original_transmitted + sim->num_retransmissions + sim->num_ack_sent);
+  double corrupted_ratio = (double)sim->num_corrupted /
+                           (sim->num_original_transmitted + sim->num_retransmissions + sim->num_ack_sent - (sim->num_retransmissions - sim->num_corrupted));
+  double backlog_delay_avg = sim->num_backlogged - sim->backlog.count > 0
+                                 ? sim->backlog_delay_sum / (sim->num_backlogged - sim->backlog.count)
+                                 : 0.0;
+  /* the run ends as message nsimmax + 1 arrives, so nsimmax were generated */
+  const struct verifier *v = &sim->verifier;
+  int undelivered = sim->nsimmax - 1 - v->highest;
+  long delivered_bytes = (long)sim->num_delivered * sim->payload_size;
+  double goodput = delivered_bytes / sim->time_now;
+#if defined(TRACE_RING) && !defined(NTRACE)
+  FILE *trace_out = fopen("TraceRing", "w");
+  if (trace_out)
+  {
+    trace_ring_dump(sim, trace_out);
+    fclose(trace_out);
+  }
+#endif
+
+  if (sim->STATS_FORMAT != STATS_TEXT)
+  {
+    stats_begin(sim, sim->protocol->name);
+    stats_int(sim, "original_transmitted", sim->num_original_transmitted);
+    stats_int(sim, "retransmissions", sim->num_retransmissions);
+    stats_int(sim, "delivered", sim->num_delivered);
+    stats_int(sim, "acks_sent", sim->num_ack_sent);
+    stats_int(sim, "acks_received", sim->num_ack_received);
+    stats_int(sim, "corrupted", sim->num_corrupted);
+    stats_double(sim, "lost_ratio", lost_ratio);
+    stats_double(sim, "corrupted_ratio", corrupted_ratio);
+    stats_double(sim, "avg_rtt", sim->rtt_sum / sim->rtt_count);
+    stats_int(sim, "rtt_count", sim->rtt_count);
+    stats_double(sim, "avg_comm_time", sim->comm_time_sum / sim->comm_time_count);
+    stats_int(sim, "comm_time_count", sim->comm_time_count);
+    stats_double(sim, "avg_completion_time", sim->completion_time_sum / sim->comm_time_count);
+    hist_stats(sim, (const char *const[]){"rtt_p50", "rtt_p90", "rtt_p99", "rtt_p999", "rtt_max"}, &sim->rtt_hist);
+    hist_stats(sim, (const char *const[]){"e2e_delay_p50", "e2e_delay_p90", "e2e_delay_p99", "e2e_delay_p999", "e2e_delay_max"},
+               &sim->e2e_hist);
+    hist_stats(sim, (const char *const[]){"retx_p50", "retx_p90", "retx_p99", "retx_p999", "retx_max"}, &sim->retx_hist);
+    stats_int(sim, "sndbuf_slots", sim->A_ent.mask + 1);
+    stats_int(sim, "backlogged", sim->num_backlogged);
+    stats_int(sim, "backlog_peak", sim->backlog_peak);
+    stats_double(sim, "avg_backlog_delay", backlog_delay_avg);
+    stats_double(sim, "max_backlog_delay", sim->backlog_delay_max);
+    stats_int(sim, "delivered_bytes", delivered_bytes);
+    stats_int(sim, "bytes_sent_a", sim->nbytes[A]);
+    stats_int(sim, "bytes_sent_b", sim->nbytes[B]);
+    stats_double(sim, "goodput", goodput);
+    stats_int(sim, "loss_bursts", sim->nbursts);
+    stats_double(sim, "ge_to_bad", sim->loss_model == LOSS_GILBERT ? sim->ge_to_bad : NAN);
+    stats_double(sim, "ge_to_good", sim->loss_model == LOSS_GILBERT ? sim->ge_to_good : NAN);
+    stats_double(sim, "ge_loss_good", sim->loss_model == LOSS_GILBERT ? sim->ge_loss_good : NAN);
+    stats_double(sim, "ge_loss_bad", sim->loss_model == LOSS_GILBERT ? sim->ge_loss_bad : NAN);
+    stats_int(sim, "ge_bad_packets", sim->nbad);
+    stats_int(sim, "spurious_retransmissions", sim->nspurious);
+    hist_stats(sim, (const char *const[]){"rcvbuf_p50", "rcvbuf_p90", "rcvbuf_p99", "rcvbuf_p999", "rcvbuf_max"},
+               &sim->rcvbuf_hist);
+    stats_double(sim, "reorder", sim->reorder);
+    stats_int(sim, "reorder_depth", sim->reorder_depth);
+    stats_int(sim, "channel_held", sim->nheld);
+    stats_int(sim, "channel_reordered", sim->nreordered);
+    bool red = sim->link_model == LINK_BOTTLENECK && sim->aqm == AQM_RED;
+    stats_string(sim, "link", link_models[sim->link_model]);
+    stats_double(sim, "bandwidth", sim->link_model == LINK_BOTTLENECK ? sim->bandwidth : NAN);
+    stats_double(sim, "prop_delay", sim->link_model == LINK_BOTTLENECK ? sim->prop_delay : NAN);
+    stats_int(sim, "queue", sim->link_model == LINK_BOTTLENECK ? sim->queue_size : 0);
+    stats_string(sim, "aqm", sim->link_model == LINK_BOTTLENECK ? aqms[sim->aqm] : "");
+    stats_double(sim, "red_min", red ? sim->red_min : NAN);
+    stats_double(sim, "red_max", red ? sim->red_max : NAN);
+    stats_double(sim, "red_maxp", red ? sim->red_maxp : NAN);
+    stats_double(sim, "red_weight", red ? sim->red_weight : NAN);
+    stats_int(sim, "queue_drops_a", sim->link[A].drops);
+    stats_int(sim, "queue_drops_b", sim->link[B].drops);
+    stats_int(sim, "queue_peak_a", sim->link[A].peak);
+    stats_int(sim, "queue_peak_b", sim->link[B].peak);
+    stats_double(sim, "avg_queue_delay_a", link_average(&sim->link[A], sim->link[A].queue_delay_sum));
+    stats_double(sim, "avg_queue_delay_b", link_average(&sim->link[B], sim->link[B].queue_delay_sum));
+    stats_double(sim, "max_queue_delay_a", sim->link[A].queue_delay_max);
+    stats_double(sim, "max_queue_delay_b", sim->link[B].queue_delay_max);
+    stats_double(sim, "avg_serialization_a", link_average(&sim->link[A], sim->link[A].serialization_sum));
+    stats_double(sim, "avg_serialization_b", link_average(&sim->link[B], sim->link[B].serialization_sum));
+    if (sim->verify)
+    {
+      stats_int(sim, "verify_in_order", v->in_order);
+      stats_int(sim, "verify_reordered", v->reordered);
+      stats_int(sim, "verify_duplicates", v->duplicates);
+      stats_int(sim, "verify_malformed", v->malformed);
+      stats_int(sim, "verify_gaps", verify_gaps(v));
+      stats_int(sim, "verify_undelivered", undelivered);
+      stats_int(sim, "verify_first_divergence", v->first_divergence);
+    }
+    stats_end(sim);
+    return;
+  }
+
+  /* TO PRINT THE STATISTICS, FILL IN THE DETAILS BY PUTTING VARIBALE NAMES. DO NOT CHANGE THE FORMAT OF PRINTED OUTPUT */
+  printf("\n\n===============STATISTICS======================= \n\n");
+  printf("Number of original packets transmitted by A: %d \n", sim->num_original_transmitted);
+  printf("Number of retransmissions by A: %d \n", sim->num_retransmissions);
+  printf("Number of data packets delivered to layer 5 at B: %d \n", sim->num_delivered);
+  printf("Number of ACK packets sent by B: %d \n", sim->num_ack_sent);
+  printf("Number of corrupted packets: %d \n", sim->num_corrupted);
+  printf("Ratio of lost packets: %.3f \n", lost_ratio);
+  printf("Ratio of corrupted packets: %.3f \n", corrupted_ratio);
+  printf("Average RTT: %.3f \n", sim->rtt_sum / sim->rtt_count);
+  printf("Average communication time: %.3f \n", sim->comm_time_sum / sim->comm_time_count);
+  printf("==================================================");
+
+  /* PRINT YOUR OWN STATISTIC HERE TO CHECK THE CORRECTNESS OF YOUR PROGRAM */
+  printf("\nEXTRA: \n");
+  /* EXAMPLE GIVEN BELOW */
+  printf("Number of ACK packets received by A: %d \n", sim->num_ack_received);
+  printf("Total RTT: %.3f \n", sim->rtt_sum);
+  printf("Number of RTT measurements: %d \n", sim->rtt_count);
+  printf("Total communication time: %.3f \n", sim->comm_time_sum);
+  printf("Number of communication time measurements: %d \n", sim->comm_time_count);
+  printf("Average completion time (layer 5 to final ACK): %.3f \n", sim->completion_time_sum / sim->comm_time_count);
+  hist_print("RTT", &sim->rtt_hist);
+  hist_print("End-to-end delay (layer 5 to layer 5)", &sim->e2e_hist);
+  hist_print("Retransmissions per packet", &sim->retx_hist);
+  printf("Send buffer size (slots): %d \n", sim->A_ent.mask + 1);
+  printf("Messages queued by backpressure: %d \n", sim->num_backlogged);
+  printf("Peak backlog (messages): %d \n", sim->backlog_peak);
+  printf("Average backlog delay: %.3f \n", backlog_delay_avg);
+  printf("Maximum backlog delay: %.3f \n", sim->backlog_delay_max);
+  printf("Payload bytes delivered: %ld (%d per message) \n", delivered_bytes, sim->payload_size);
+  printf("Bytes sent into layer 3 (A, B): %ld, %ld \n", sim->nbytes[A], sim->nbytes[B]);
+  printf("Goodput (payload bytes per time unit): %.3f \n", goodput);
+  printf("Payload share of bytes sent: %.3f \n", (double)delivered_bytes / (sim->nbytes[A] + sim->nbytes[B]));
+  printf("Loss bursts: %d (%.3f packets on average) \n", sim->nbursts, sim->nbursts ? (double)sim->nlost / sim->nbursts : 0.0);
+  if (sim->loss_model == LOSS_GILBERT)
+    printf("Packets sent in the bad state: %d of %d \n", sim->nbad, sim->ntolayer3);
+  printf("Spurious retransmissions (data reaching B intact again): %d \n", sim->nspurious);
+  hist_print("Receiver buffer occupancy (packets)", &sim->rcvbuf_hist);
+  if (sim->reorder > 0.0)
+    printf("Packets held back: %d, overtaken by %d others: %d \n", sim->nheld, sim->reorder_depth, sim->nreordered);
+  if (sim->link_model == LINK_BOTTLENECK)
+  {
+    const struct link *a = &sim->link[A], *b = &sim->link[B];
+    printf("Queue drops (A to B, B to A): %d, %d; peak queue %d, %d packets \n", a->drops, b->drops, a->peak, b->peak);
+    printf("Average queueing delay (A to B, B to A): %.3f, %.3f; maximum %.3f, %.3f \n",
+           link_average(a, a->queue_delay_sum), link_average(b, b->queue_delay_sum), a->queue_delay_max,
+           b->queue_delay_max);
+    printf("Average serialization delay (A to B, B to A): %.3f, %.3f \n", link_average(a, a->serialization_sum),
+           link_average(b, b->serialization_sum));
+  }
+  if (sim->verify)
+  {
+    printf("Delivery check: %d in order, %d reordered, %d duplicates, %d malformed, %d gaps, %d undelivered at end \n",
+           v->in_order, v->reordered, v->duplicates, v->malformed, verify_gaps(v), undelivered);
+    if (v->first_divergence >= 0)
+      printf("Delivery check: first divergence at delivery %ld, expected message %d ('%c'), got '%c' \n",
+             v->first_divergence, v->divergence_expected, 'a' + v->divergence_expected % 26, v->divergence_got);
+  }
+}
+
+/********* SELECTIVE REPEAT WITH CUMULATIVE ACKS *********/
+/* The receiver buffers out-of-order packets; the sender retransmits   */
+/* only the first unACKed packet, on a timeout or a duplicate ACK.      */
+
+void deliver_subseq_data(struct sim *sim)
+{
+  if (slot_present(sim->B_ent.present, sim->B_ent.mask, sim->B_ent.window_start))
+  {
+    // Deliver subsequent data packets waiting in the buffer
+    PTRACE("  deliver_subseq_data: delivering (window_start_seqnum=%d)\n",
+           sim->B_ent.packet_buffer[sim->B_ent.window_start & sim->B_ent.mask].seqnum);
+    do
+    {
+      tolayer5(sim, sim->B_ent.packet_buffer[sim->B_ent.window_start & sim->B_ent.mask].payload);
+      sim->num_delivered++;
+      record_delivery(sim, sim->B_ent.window_start);
+      clear_slot(sim->B_ent.present, sim->B_ent.mask, sim->B_ent.window_start);
+    } while (slot_present(sim->B_ent.present, sim->B_ent.mask, ++sim->B_ent.window_start));
+    PTRACE("  deliver_subseq_data: delivered (window_start_seqnum=%d)\n",
+           sim->B_ent.window_start % sim->LIMIT_SEQNO);
+  }
+}
+
+void print_packet(struct sim *sim, const uint64_t *present, struct pkt *buffer, int mask, int i)
+{
+  if (slot_present(present, mask, i))
+    PTRACE(" %d", buffer[i & mask].seqnum);
+  else
+    PTRACE(" -");
+}
+
+void sr_print_window(struct sim *sim, int AorB)
+{
+  if (!PTRACE_ENABLED)
+    return;
+  if (AorB == A)
+  {
+    PTRACE("  A_window:");
+    for (int i = sim->A_ent.window_start; i < sim->A_ent.window_start + sim->WINDOW_SIZE; i++)
+    {
+      print_packet(sim, sim->A_ent.present, sim->A_ent.packet_buffer, sim->A_ent.mask, i);
+    }
+  }
+  else
+  {
+    PTRACE("  B_window:");
+    for (int i = sim->B_ent.window_start; i < sim->B_ent.window_start + sim->WINDOW_SIZE; i++)
+    {
+      print_packet(sim, sim->B_ent.present, sim->B_ent.packet_buffer, sim->B_ent.mask, i);
+    }
+  }
+  PTRACE("\n");
+}
+
+void retransmit_first_outstanding_packet(struct sim *sim)
+{
+  int i = sim->A_ent.window_start;
+  while (i < sim->A_ent.send_next && !slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+  {
+    i++;
+  }
+  if (slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+  {
+    struct pkt *first_packet = &sim->A_ent.packet_buffer[i & sim->A_ent.mask];
+    PTRACE("retransmit first outstanding packet (seq=%d): %.*s\n",
+           first_packet->seqnum, TRACE_BYTES(sim), first_packet->payload);
+    sim->A_ent.retransmissions[i & sim->A_ent.mask]++;
+    sim->num_retransmissions++;
+    restart_rxmt_timer(sim);
+    tolayer3(sim, A, *first_packet);
+  }
+}
+
+/* called from layer 3, when a packet arrives for layer 4 */
+void sr_A_input(struct sim *sim, struct pkt ack_packet)
+{
+  sr_print_window(sim, A);
+  sim->num_ack_received++;
+
+  if (ack_packet.checksum != get_checksum(sim, ack_packet, 0))
+  {
+    sim->num_corrupted++;
+    PTRACE("  A_input: recv corrupted ACK\n");
+    return;
+  }
+
+  if (!ack_in_window(sim, ack_packet.acknum))
+  {
+    PTRACE("  A_input: ACK outside of window (ack=%d)\n", ack_packet.acknum);
+    return;
+  }
+
+  if (ack_packet.acknum == sim->A_ent.last_ack)
+  {
+    PTRACE("  A_input: Case4 -> recv duplicate ACK (ack=%d)\n", ack_packet.acknum);
+    retransmit_first_outstanding_packet(sim);
+  }
+
+  PTRACE("  A_input: recv new ACK (ack=%d)\n", ack_packet.acknum);
+  sim->A_ent.last_ack = ack_packet.acknum;
+
+  // Move window forward
+  int i = sim->A_ent.window_start;
+  for (; i < sim->A_ent.send_next && i % sim->LIMIT_SEQNO != ack_packet.acknum; i++)
+  {
+    clear_slot(sim->A_ent.present, sim->A_ent.mask, i);
+    record_time_measurement(sim, i);
+  }
+  int diff = i - sim->A_ent.window_start;
+  if (diff > 0)
+  {
+    PTRACE("  A_input: moved window by %d (window_start=%d, send_next=%d)\n",
+           diff, i % sim->LIMIT_SEQNO, sim->A_ent.send_next % sim->LIMIT_SEQNO);
+    sim->A_ent.window_start = i;
+    drain_backlog(sim);
+    // Send any new packets waiting in the buffer
+    send_window(sim);
+  }
+}
+
+/* called when A's timer goes off */
+void sr_A_timerinterrupt(struct sim *sim)
+{
+  if (sim->A_ent.window_start == sim->A_ent.send_next)
+    return;
+
+  PTRACE("  A_timerinterrupt: timeout (window_start=%d, send_next=%d)\n",
+         sim->A_ent.window_start % sim->LIMIT_SEQNO, sim->A_ent.send_next % sim->LIMIT_SEQNO);
+  retransmit_first_outstanding_packet(sim);
+}
+
+/* called from layer 3, when a packet arrives for layer 4 at B*/
+void sr_B_input(struct sim *sim, struct pkt packet)
+{
+  if (packet.checksum != get_checksum(sim, packet, sim->payload_size))
+  {
+    sim->num_corrupted++;
+    PTRACE("  B_input: recv corrupted packet\n");
+    return;
+  }
+
+  sr_print_window(sim, B);
+
+  int cur_seqnum = sim->B_ent.window_start % sim->LIMIT_SEQNO;
+  if (cur_seqnum == packet.seqnum) // In-order packet
+  {
+    PTRACE("  B_input: recv in-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    tolayer5(sim, packet.payload);
+    sim->num_delivered++;
+    record_delivery(sim, sim->B_ent.window_start);
+    sim->B_ent.window_start++;
+    deliver_subseq_data(sim);
+  }
+  else // Out-of-order packet
+  {
+    // Find position of received packet in buffer
+    int i = sim->B_ent.window_start + 1;
+    cur_seqnum = i % sim->LIMIT_SEQNO;
+    while (i < sim->B_ent.window_start + sim->WINDOW_SIZE && cur_seqnum != packet.seqnum)
+    {
+      i++;
+      cur_seqnum = i % sim->LIMIT_SEQNO;
+    }
+
+    if (i >= sim->B_ent.window_start + sim->WINDOW_SIZE || cur_seqnum != packet.seqnum)
+    {
+      PTRACE("  B_input: recv seqnum outside of window (seq=%d)\n", packet.seqnum);
+      send_ack(sim);
+      return;
+    }
+
+    struct pkt *buf_packet = &sim->B_ent.packet_buffer[i & sim->B_ent.mask];
+    if (slot_present(sim->B_ent.present, sim->B_ent.mask, i))
+    {
+      PTRACE("  B_input: recv duplicate packet (seq=%d): %.*s\n",
+             buf_packet->seqnum, TRACE_BYTES(sim), buf_packet->payload);
+      return;
+    }
+
+    PTRACE("  B_input: recv new, out-of-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    buf_packet->seqnum = packet.seqnum;
+    memmove(buf_packet->payload, packet.payload, sim->payload_size);
+    set_slot(sim->B_ent.present, sim->B_ent.mask, i);
+  }
+
+  // Send ACK for expected packet
+  send_ack(sim);
+}
+
+/* the following routine will be called once (only) before any other */
+/* entity B routines are called. You can use it to do any initialization */
+void sr_B_init(struct sim *sim)
+{
+  sim->B_ent.window_start = FIRST_SEQNO;
+  sim->B_ent.ack_pkt.seqnum = -1;
+  memset(sim->B_ent.ack_pkt.sack, -1, sizeof(sim->B_ent.ack_pkt.sack));
+  int size = round_up_pow2(sim->WINDOW_SIZE);
+  sim->B_ent.mask = size - 1;
+  sim->B_ent.packet_buffer = alloc_packets(size, sim->payload_size, &sim->B_ent.payloads);
+  sim->B_ent.present = alloc_or_die(BITMAP_WORDS(size), sizeof(uint64_t));
+}
+
+const struct protocol protocol_sr = {"sr", sr_A_input, sr_A_timerinterrupt, sr_B_input, sr_B_init};
+
+/********* GO-BACK-N WITH SELECTIVE ACKS *********/
+/* The receiver delivers and SACKs up to 5 packets past the one it     */
+/* expects; on a timeout the sender retransmits every outstanding      */
+/* packet that has not been selectively ACKed.                          */
+
+void gbn_sack_print_window(struct sim *sim, int AorB)
+{
+  if (!PTRACE_ENABLED)
+    return;
+  if (AorB == A)
+  {
+    PTRACE("  A_window:");
+    for (int i = sim->A_ent.window_start; i < sim->A_ent.window_start + sim->WINDOW_SIZE; i++)
+    {
+      if (slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+        PTRACE(" %d", sim->A_ent.packet_buffer[i & sim->A_ent.mask].seqnum);
+      else
+        PTRACE(" -");
+    }
+  }
+  else
+  {
+    PTRACE("  B_window: %d", sim->B_ent.window_start % sim->LIMIT_SEQNO);
+    PTRACE(" (SACK:");
+    for (int i = 0; i < 5; i++)
+    {
+      int val = sim->B_ent.ack_pkt.sack[i];
+      if (val >= 0)
+        PTRACE(" %d", val);
+      else
+        PTRACE(" -");
+    }
+    PTRACE(")");
+  }
+  PTRACE("\n");
+}
+
+bool insert_sack(struct sim *sim, struct pkt packet)
+{
+  int sack_start = sim->B_ent.window_start + 1;
+  for (int i = 0; i < 5; i++)
+  {
+    if ((sack_start + i) % sim->LIMIT_SEQNO == packet.seqnum)
+    {
+      if (sim->B_ent.ack_pkt.sack[i] >= 0)
+      {
+        PTRACE("  insert_sack: duplicate SACK (seq=%d)\n", packet.seqnum);
+        return false;
+      }
+      PTRACE("  insert_sack: deliver packet and insert SACK (seq=%d)\n", packet.seqnum);
+      tolayer5(sim, packet.payload);
+      sim->num_delivered++;
+      record_delivery(sim, sack_start + i);
+      sim->B_ent.ack_pkt.sack[i] = packet.seqnum;
+      return true;
+    }
+  }
+  return false;
+}
+
+int sack_offset(struct sim *sim)
+{
+  int i;
+  for (i = 0; i < 5; i++)
+  {
+    if (sim->B_ent.ack_pkt.sack[i] < 0)
+    {
+      break;
+    }
+  }
+  return i;
+}
+
+/* called from layer 3, when a packet arrives for layer 4 */
+void gbn_sack_A_input(struct sim *sim, struct pkt ack_packet)
+{
+  gbn_sack_print_window(sim, A);
+  sim->num_ack_received++;
+
+  if (ack_packet.checksum != get_checksum(sim, ack_packet, 0))
+  {
+    sim->num_corrupted++;
+    PTRACE("  A_input: recv corrupted ACK\n");
+    return;
+  }
+
+  PTRACE("  A_input: recv ACK (ack=%d)\n", ack_packet.acknum);
+
+  if (!ack_in_window(sim, ack_packet.acknum))
+  {
+    PTRACE("  A_input: ACK outside of window (ack=%d)\n", ack_packet.acknum);
+    return;
+  }
+
+  if (ack_packet.acknum == sim->A_ent.window_start % sim->LIMIT_SEQNO)
+  {
+    // process SACKs
+    for (int i = 0, j = sim->A_ent.window_start + 1; i < 5 && j < sim->A_ent.send_next; i++, j++)
+    {
+      int sack = ack_packet.sack[i];
+      if (sack >= 0 && slot_present(sim->A_ent.present, sim->A_ent.mask, j))
+      {
+        PTRACE("  A_input: recv SACK (seq=%d)\n", sack);
+        clear_slot(sim->A_ent.present, sim->A_ent.mask, j);
+        record_time_measurement(sim, j);
+      }
+    }
+    return;
+  }
+
+  // Move window forward
+  int i = sim->A_ent.window_start;
+  for (; i < sim->A_ent.send_next && i % sim->LIMIT_SEQNO != ack_packet.acknum; i++)
+  {
+    if (slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+    {
+      clear_slot(sim->A_ent.present, sim->A_ent.mask, i);
+      record_time_measurement(sim, i);
+    }
+  }
+  int diff = i - sim->A_ent.window_start;
+  if (diff > 0)
+  {
+    PTRACE("  A_input: moved window by %d (window_start=%d, send_next=%d)\n",
+           diff, i % sim->LIMIT_SEQNO, sim->A_ent.send_next % sim->LIMIT_SEQNO);
+    sim->A_ent.window_start = i;
+    drain_backlog(sim);
+  }
+  if (sim->A_ent.window_start == sim->A_ent.send_next) // Send any new packets waiting in the buffer
+  {
+    send_window(sim);
+  }
+}
+
+/* called when A's timer goes off */
+void gbn_sack_A_timerinterrupt(struct sim *sim)
+{
+  if (sim->A_ent.window_start == sim->A_ent.send_next)
+    return;
+  starttimer(sim, A, sim->RXMT_TIMEOUT);
+  for (int i = sim->A_ent.window_start; i < sim->A_ent.send_next; i++)
+  {
+    if (slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+    {
+      struct pkt *packet = &sim->A_ent.packet_buffer[i & sim->A_ent.mask];
+      PTRACE("  A_timerinterrupt: Case3 -> retransmit unACKed packet (seq=%d): %.*s\n",
+             packet->seqnum, TRACE_BYTES(sim), packet->payload);
+      tolayer3(sim, A, *packet);
+      sim->A_ent.retransmissions[i & sim->A_ent.mask]++;
+      sim->num_retransmissions++;
+    }
+  }
+}
+
+/* called from layer 3, when a packet arrives for layer 4 at B*/
+void gbn_sack_B_input(struct sim *sim, struct pkt packet)
+{
+  if (packet.checksum != get_checksum(sim, packet, sim->payload_size))
+  {
+    sim->num_corrupted++;
+    PTRACE("  B_input: recv corrupted packet\n");
+    return;
+  }
+
+  gbn_sack_print_window(sim, B);
+  if (packet.seqnum != sim->B_ent.window_start % sim->LIMIT_SEQNO)
+  {
+    PTRACE("  B_input: recv out-of-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    if (!insert_sack(sim, packet))
+    {
+      PTRACE("  B_input: drop packet (seq=%d): %.*s\n",
+             packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    }
+  }
+  else
+  {
+    PTRACE("  B_input: recv in-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    tolayer5(sim, packet.payload);
+    sim->num_delivered++;
+    record_delivery(sim, sim->B_ent.window_start);
+    int offset = 1 + sack_offset(sim);
+    sim->B_ent.window_start += offset;
+    for (int i = 0; i < 5; i++) // shift SACK
+    {
+      sim->B_ent.ack_pkt.sack[i] = i + offset < 5 ? sim->B_ent.ack_pkt.sack[i + offset] : -1;
+    }
+  }
+
+  send_ack(sim);
+}
+
+/* the following rouytine will be called once (only) before any other */
+/* entity B routines are called. You can use it to do any initialization */
+void gbn_sack_B_init(struct sim *sim)
+{
+  sim->B_ent.window_start = FIRST_SEQNO;
+  sim->B_ent.ack_pkt.seqnum = -1;
+  memset(sim->B_ent.ack_pkt.sack, -1, sizeof(sim->B_ent.ack_pkt.sack));
+}
+
+const struct protocol protocol_gbn_sack = {"gbn-sack", gbn_sack_A_input, gbn_sack_A_timerinterrupt,
+                                           gbn_sack_B_input, gbn_sack_B_init};
+
+/********* GO-BACK-N *********/
+/* The receiver discards anything but the packet it expects and ACKs   */
+/* cumulatively; on a timeout the sender retransmits every packet in   */
+/* the window.                                                          */
+
+void gbn_print_window(struct sim *sim, int AorB)
+{
+  if (!PTRACE_ENABLED)
+    return;
+  if (AorB == A)
+  {
+    PTRACE("  A_window:");
+    for (int i = sim->A_ent.window_start; i < sim->A_ent.window_start + sim->WINDOW_SIZE; i++)
+    {
+      if (slot_present(sim->A_ent.present, sim->A_ent.mask, i))
+        PTRACE(" %d", sim->A_ent.packet_buffer[i & sim->A_ent.mask].seqnum);
+      else
+        PTRACE(" -");
+    }
+  }
+  else
+    PTRACE("  B_window: %d", sim->B_ent.window_start % sim->LIMIT_SEQNO);
+  PTRACE("\n");
+}
+
+void gbn_A_input(struct sim *sim, struct pkt ack_packet)
+{
+  gbn_print_window(sim, A);
+  sim->num_ack_received++;
+
+  if (ack_packet.checksum != get_checksum(sim, ack_packet, 0))
+  {
+    sim->num_corrupted++;
+    PTRACE("  A_input: recv corrupted ACK\n");
+    return;
+  }
+
+  PTRACE("  A_input: recv ACK (ack=%d)\n", ack_packet.acknum);
+
+  // Everything before the acknum has arrived; a duplicate ACK moves nothing
+  int i = sim->A_ent.window_start;
+  while (i < sim->A_ent.send_next && i % sim->LIMIT_SEQNO != ack_packet.acknum)
+    i++;
+  if (i % sim->LIMIT_SEQNO != ack_packet.acknum)
+  {
+    PTRACE("  A_input: ACK outside of window (ack=%d)\n", ack_packet.acknum);
+    return;
+  }
+  int diff = i - sim->A_ent.window_start;
+  if (diff > 0)
+  {
+    for (int j = sim->A_ent.window_start; j < i; j++)
+    {
+      clear_slot(sim->A_ent.present, sim->A_ent.mask, j);
+      record_time_measurement(sim, j);
+    }
+    PTRACE("  A_input: moved window by %d (window_start=%d, send_next=%d)\n",
+           diff, i % sim->LIMIT_SEQNO, sim->A_ent.send_next % sim->LIMIT_SEQNO);
+    sim->A_ent.window_start = i;
+    if (i < sim->A_ent.send_next)
+      restart_rxmt_timer(sim);
+    drain_backlog(sim);
+    send_window(sim);
+  }
+}
+
+void gbn_A_timerinterrupt(struct sim *sim)
+{
+  if (sim->A_ent.window_start == sim->A_ent.send_next)
+    return;
+  starttimer(sim, A, sim->RXMT_TIMEOUT);
+  for (int i = sim->A_ent.window_start; i < sim->A_ent.send_next; i++)
+  {
+    struct pkt *packet = &sim->A_ent.packet_buffer[i & sim->A_ent.mask];
+    PTRACE("  A_timerinterrupt: retransmit packet (seq=%d): %.*s\n",
+           packet->seqnum, TRACE_BYTES(sim), packet->payload);
+    tolayer3(sim, A, *packet);
+    sim->A_ent.retransmissions[i & sim->A_ent.mask]++;
+    sim->num_retransmissions++;
+  }
+}
+
+void gbn_B_input(struct sim *sim, struct pkt packet)
+{
+  if (packet.checksum != get_checksum(sim, packet, sim->payload_size))
+  {
+    sim->num_corrupted++;
+    PTRACE("  B_input: recv corrupted packet\n");
+    return;
+  }
+
+  gbn_print_window(sim, B);
+  if (packet.seqnum == sim->B_ent.window_start % sim->LIMIT_SEQNO)
+  {
+    PTRACE("  B_input: recv in-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+    tolayer5(sim, packet.payload);
+    sim->num_delivered++;
+    record_delivery(sim, sim->B_ent.window_start);
+    sim->B_ent.window_start++;
+  }
+  else
+    PTRACE("  B_input: drop out-of-order packet (seq=%d): %.*s\n",
+           packet.seqnum, TRACE_BYTES(sim), packet.payload);
+
+  send_ack(sim);
+}
+
+void gbn_B_init(struct sim *sim)
+{
+  sim->B_ent.window_start = FIRST_SEQNO;
+  sim->B_ent.ack_pkt.seqnum = -1;
+  memset(sim->B_ent.ack_pkt.sack, -1, sizeof(sim->B_ent.ack_pkt.sack));
+}
+
+const struct protocol protocol_gbn = {"gbn", gbn_A_input, gbn_A_timerinterrupt, gbn_B_input, gbn_B_init};
+
+/* indexed by the protocol parameter, in the order of protocol_names[] */
+const struct protocol *const protocols[] = {&protocol_sr, &protocol_gbn_sack, &protocol_gbn};
+const char *const protocol_names[] = {"sr", "gbn-sack", "gbn", NULL};
+
+/*****************************************************************
+***************** NETWORK EMULATION CODE STARTS BELOW ***********
+The code below emulates the layer 3 and below network environment:
+  - emulates the tranmission and delivery (possibly with bit-level corruption
+    and packet loss) of packets across the layer 3/4 interface
+  - handles the starting/stopping of a timer, and generates timer
+    interrupts (resulting in calling students timer handler).
+  - generates message to be sent (passed from later 5 to 4)
+
+THERE IS NOT REASON THAT ANY STUDENT SHOULD HAVE TO READ OR UNDERSTAND
+THE CODE BELOW.  YOU SHOLD NOT TOUCH, OR REFERENCE (in your code) ANY
+OF THE DATA STRUCTURES BELOW.  If you're interested in how I designed
+the emulator, you're welcome to look at the code - but again, you should have
+to, and you defeinitely should not have to modify
+******************************************************************/
+
+struct event
+{
+  double evtime;      /* event time */
+  int evtype;         /* event type code */
+  int eventity;       /* entity where event occurs */
+  struct pkt pkt;      /* packet (if any) assoc w/ this event */
+  char *payload;       /* storage for the packet's payload */
+  unsigned long evseq; /* insertion order, breaks ties on equal evtime */
+  bool cancelled;      /* stopped timer, discarded when it reaches the front */
+  struct event *nextfree; /* free list link while the event is in the pool */
+  int msgno;           /* A's send index of an intact data packet, else -1 */
+};
+
+/* events are carved out of slabs of EVPOOL_SLAB and recycled through a  */
+/* free list, so a long run settles at a fixed footprint and stops       */
+/* calling malloc/free per packet.  Each slab ends with the payload      */
+/* storage of its events.                                                */
+#define EVPOOL_SLAB 256
+
+/* Advance declarations. */
+void init(struct sim *sim, int argc, char **argv);
+void A_init(struct sim *sim);
+void free_entities(struct sim *sim);
+void generate_next_arrival(struct sim *sim);
+void insertevent(struct sim *sim, struct event *p);
+struct event *popevent(struct sim *sim);
+struct event *allocevent(struct sim *sim);
+void freeevent(struct sim *sim, struct event *p);
+
+/* possible events: */
+#define TIMER_INTERRUPT 0
+#define FROM_LAYER5 1
+#define FROM_LAYER3 2
+
+#define OFF 0
+#define ON 1
+
+/* emulator log levels.  A message is printed when the run's TRACE level    */
+/* is at least its level; levels above LOG_MAX_LEVEL are compiled out, so   */
+/* -DLOG_MAX_LEVEL=0 builds an emulator that never formats a trace line.    */
+#define LOG_WARN 1  /* timer misuse, packets lost or corrupted */
+#define LOG_EVENT 2 /* every event taken off the event list */
+#define LOG_DEBUG 3 /* event list, timer and channel internals */
+#define LOG_RAND 4  /* every random draw */
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_RAND
+#endif
+#define LOG_ENABLED(level) ((level) <= LOG_MAX_LEVEL && sim->TRACE >= (level))
+#define LOG(level, ...)         \
+  do                            \
+  {                             \
+    if (LOG_ENABLED(level))     \
+      printf(__VA_ARGS__);      \
+  } while (0)
+
+/* -DNO_MAIN leaves main() out, for programs that include this file and */
+/* drive runs themselves through sim_create() and sim_run()             */
+#ifndef NO_MAIN
+int main(int argc, char **argv)
+{
+  struct sim *sim = sim_create();
+
+  init(sim, argc, argv);
+  sim_start(sim);
+  sim_run(sim);
+  Simulation_done(sim); /* allow students to output statistics */
+  if (sim->STATS_FORMAT == STATS_TEXT)
+  {
+    printf("Simulator terminated at time %.12f\n", sim->time_now);
+    printf("Event pool: peak %d events in use, %d slabs (%lu bytes, event list %lu bytes)\n",
+           sim->evpool_peak, sim->evpool_slabs,
+           (unsigned long)sim->evpool_slabs * EVPOOL_SLAB * (sizeof(struct event) + sim->payload_size),
+           (unsigned long)sim->evcapacity * sizeof(struct event *));
+  }
+  sim_destroy(sim);
+  return (0);
+}
+#endif
+
+/* a run with every parameter at its default and no output file; set the */
+/* parameters, directly or with set_param(), before sim_start()          */
+struct sim *sim_create(void)
+{
+  struct sim *sim = alloc_or_die(1, sizeof(struct sim));
+  sim->TRACE = 0;
+  sim->STATS_FORMAT = STATS_TEXT;
+  sim->nsimmax = 1000;
+  sim->lambda = 200.0;
+  sim->WINDOW_SIZE = 8;
+  sim->RXMT_TIMEOUT = 30.0;
+  sim->payload_size = 20;
+  sim->seed[0] = 1;
+  sim->ge_to_bad = 0.01;
+  sim->ge_to_good = 0.25;
+  sim->ge_loss_bad = 1.0;
+  sim->bandwidth = 10.0;
+  sim->prop_delay = 5.0;
+  sim->queue_size = 32;
+  sim->red_min = 8.0;
+  sim->red_max = 24.0;
+  sim->red_maxp = 0.1;
+  sim->red_weight = 0.002;
+  sim->sndbuf_max = SNDBUF_MAX;
+  sim->backpressure = BACKPRESSURE;
+  sim->fileoutput = -1;
+  sim->rtt_hist.unit = 0.001;
+  sim->e2e_hist.unit = 0.001;
+  sim->retx_hist.unit = 1;
+  sim->rcvbuf_hist.unit = 1;
+  sim->reorder_depth = 3;
+  return sim;
+}
+
+/* simulate until the event list runs dry or the last message is generated */
+void sim_run(struct sim *sim)
+{
+  struct event *eventptr;
+  struct msg msg2give;
+  struct pkt pkt2give;
+
+  int i, j;
+
+  while (1)
+  {
+    eventptr = popevent(sim); /* get next event to simulate */
+    if (eventptr == NULL)
+      return;
+    if (eventptr->cancelled)
+    {
+      freeevent(sim, eventptr);
+      continue;
+    }
+    if (LOG_ENABLED(LOG_EVENT))
+    {
+      printf("\nEVENT time: %f,", eventptr->evtime);
+      printf("  type: %d", eventptr->evtype);
+      if (eventptr->evtype == 0)
+        printf(", timerinterrupt  ");
+      else if (eventptr->evtype == 1)
+        printf(", fromlayer5 ");
+      else
+        printf(", fromlayer3 ");
+      printf(" entity: %d\n", eventptr->eventity);
+    }
+    sim->time_now = eventptr->evtime; /* update time to next event time */
+    if (eventptr->evtype == FROM_LAYER5)
+    {
+      generate_next_arrival(sim); /* set up future arrival */
+                                  /* fill in msg to give with string of same letter */
+      j = sim->nsim % 26;
+      msg2give.data = sim->msgbuf;
+      memset(msg2give.data, 97 + j, sim->payload_size - 1);
+      msg2give.data[sim->payload_size - 1] = '\n';
+      sim->nsim++;
+      if (sim->nsim == sim->nsimmax + 1)
+      {
+        freeevent(sim, eventptr);
+        return;
+      }
+      A_output(sim, msg2give);
+    }
+    else if (eventptr->evtype == FROM_LAYER3)
+    {
+      pkt2give.seqnum = eventptr->pkt.seqnum;
+      pkt2give.acknum = eventptr->pkt.acknum;
+      pkt2give.checksum = eventptr->pkt.checksum;
+      pkt2give.payload = eventptr->pkt.payload;
+      for (i = 0; i < 5; i++)
+        pkt2give.sack[i] = eventptr->pkt.sack[i];
+      if (eventptr->eventity == A)                  /* deliver packet by calling */
+        sim->protocol->A_input(sim, pkt2give);      /* appropriate entity */
+      else
+      {
+        note_arrival(sim, eventptr->msgno);
+        sim->protocol->B_input(sim, pkt2give);
+        if (sim->B_ent.present != NULL)
+          hist_record(&sim->rcvbuf_hist, receiver_occupancy(sim));
+      }
+    }
+    else if (eventptr->evtype == TIMER_INTERRUPT)
+    {
+      sim->timers[eventptr->eventity] = NULL;
+      sim->protocol->A_timerinterrupt(sim);
+    }
+    else
+    {
+      printf("INTERNAL PANIC: unknown event type \n");
+    }
+    freeevent(sim, eventptr);
+  }
+}
+
+void sim_destroy(struct sim *sim)
+{
+  int i;
+  free_entities(sim);
+  free(sim->verifier.delivered);
+  free(sim->msgbuf);
+  free(sim->arrived);
+  free(sim->link[A].depart);
+  free(sim->link[B].depart);
+  for (i = 0; i < sim->evpool_slabs; i++)
+    free(sim->evpool_slab_list[i]);
+  free(sim->evpool_slab_list);
+  free(sim->evlist);
+  output_close(sim);
+  free(sim);
+}
+
+/*********************** STATISTICS RECORD ******************/
+/* Simulation_done() reports one record per run through these */
+/* routines: a single JSON object, or a CSV header plus row.  */
+/* The record starts with the run parameters and ends with    */
+/* the emulator's own counters.                               */
+/************************************************************/
+
+void stats_add(struct sim *sim, const char *name, const char *value)
+{
+  if (sim->stats_nfields == STATS_MAX_FIELDS)
+    return;
+  sim->stats_fields[sim->stats_nfields].name = name;
+  snprintf(sim->stats_fields[sim->stats_nfields].value, sizeof(sim->stats_fields[0].value), "%s", value);
+  sim->stats_nfields++;
+}
+
+void stats_int(struct sim *sim, const char *name, long value)
+{
+  char text[40];
+  snprintf(text, sizeof(text), "%ld", value);
+  stats_add(sim, name, text);
+}
+
+/* non-finite values (e.g. an average over no samples) have no JSON */
+/* number, so they become null, or an empty CSV column              */
+void stats_double(struct sim *sim, const char *name, double value)
+{
+  char text[40];
+  if (isfinite(value))
+  {
+    /* shortest of 15 or 17 digits that reads back as the same value */
+    snprintf(text, sizeof(text), "%.15g", value);
+    if (strtod(text, NULL) != value)
+      snprintf(text, sizeof(text), "%.17g", value);
+  }
+  else
+    snprintf(text, sizeof(text), "%s", sim->STATS_FORMAT == STATS_JSON ? "null" : "");
+  stats_add(sim, name, text);
+}
+
+/* value is a word such as a parameter choice, needing no escapes */
+void stats_string(struct sim *sim, const char *name, const char *value)
+{
+  char text[40];
+  snprintf(text, sizeof(text), sim->STATS_FORMAT == STATS_JSON ? "\"%s\"" : "%s", value);
+  stats_add(sim, name, text);
+}
+
+void stats_begin(struct sim *sim, const char *protocol)
+{
+  sim->stats_nfields = 0;
+  stats_string(sim, "simulator", "arq");
+  stats_string(sim, "protocol", protocol);
+  stats_int(sim, "messages", sim->nsimmax);
+  stats_double(sim, "loss", sim->lossprob);
+  stats_double(sim, "corrupt", sim->corruptprob);
+  stats_double(sim, "lambda", sim->lambda);
+  stats_int(sim, "window", sim->WINDOW_SIZE);
+  stats_double(sim, "timeout", sim->RXMT_TIMEOUT);
+  stats_int(sim, "seed", sim->seed_param);
+  stats_int(sim, "payload", sim->payload_size);
+}
+
+void stats_end(struct sim *sim)
+{
+  int i;
+  stats_int(sim, "to_layer3", sim->ntolayer3);
+  stats_int(sim, "channel_lost", sim->nlost);
+  stats_int(sim, "channel_corrupted", sim->ncorrupt);
+  stats_double(sim, "sim_time", sim->time_now);
+  stats_int(sim, "event_pool_peak", sim->evpool_peak);
+  if (sim->STATS_FORMAT == STATS_JSON)
+  {
+    printf("{");
+    for (i = 0; i < sim->stats_nfields; i++)
+      printf("%s\"%s\": %s", i ? ", " : "", sim->stats_fields[i].name, sim->stats_fields[i].value);
+    printf("}\n");
+  }
+  else
+  {
+    for (i = 0; i < sim->stats_nfields; i++)
+      printf("%s%s", i ? "," : "", sim->stats_fields[i].name);
+    printf("\n");
+    for (i = 0; i < sim->stats_nfields; i++)
+      printf("%s%s", i ? "," : "", sim->stats_fields[i].value);
+    printf("\n");
+  }
+}
+
+/* parameters settable by name from the command line or a config file */
+#define PARAM_INT 0
+#define PARAM_DOUBLE 1
+#define PARAM_CHOICE 2 /* int index into choices */
+
+struct param
+{
+  const char *name;
+  int type;
+  size_t offset; /* of the value in struct sim */
+  const char *help;
+  const char *const *choices;
+};
+
+const char *const stats_formats[] = {"text", "json", "csv", NULL};
+const char *const output_modes[] = {"buffered", "mmap", "discard", NULL};
+const char *const checksum_types[] = {"crc32c", "sum", NULL};
+const char *const rng_types[] = {"legacy", "philox", NULL};
+const char *const loss_models[] = {"bernoulli", "gilbert", NULL};
+const char *const link_models[] = {"random", "bottleneck", NULL};
+const char *const aqms[] = {"droptail", "red", NULL};
+
+struct param params[] = {
+    {"protocol", PARAM_CHOICE, offsetof(struct sim, protocol_index), "sr, gbn-sack or gbn", protocol_names},
+    {"messages", PARAM_INT, offsetof(struct sim, nsimmax), "number of messages to simulate", NULL},
+    {"loss", PARAM_DOUBLE, offsetof(struct sim, lossprob), "packet loss probability", NULL},
+    {"loss-model", PARAM_CHOICE, offsetof(struct sim, loss_model), "packet loss: bernoulli (loss) or gilbert (the ge- parameters)", loss_models},
+    {"ge-to-bad", PARAM_DOUBLE, offsetof(struct sim, ge_to_bad), "gilbert: probability per packet of going from the good state to bad", NULL},
+    {"ge-to-good", PARAM_DOUBLE, offsetof(struct sim, ge_to_good), "gilbert: probability per packet of going from the bad state to good", NULL},
+    {"ge-loss-good", PARAM_DOUBLE, offsetof(struct sim, ge_loss_good), "gilbert: loss probability in the good state", NULL},
+    {"ge-loss-bad", PARAM_DOUBLE, offsetof(struct sim, ge_loss_bad), "gilbert: loss probability in the bad state", NULL},
+    {"link", PARAM_CHOICE, offsetof(struct sim, link_model), "packet delay: random (1 to 10, in order) or bottleneck", link_models},
+    {"bandwidth", PARAM_DOUBLE, offsetof(struct sim, bandwidth), "bottleneck: bytes serialized per time unit", NULL},
+    {"prop-delay", PARAM_DOUBLE, offsetof(struct sim, prop_delay), "bottleneck: propagation delay", NULL},
+    {"queue", PARAM_INT, offsetof(struct sim, queue_size), "bottleneck: queue capacity in packets", NULL},
+    {"aqm", PARAM_CHOICE, offsetof(struct sim, aqm), "bottleneck queue management: droptail or red", aqms},
+    {"red-min", PARAM_DOUBLE, offsetof(struct sim, red_min), "red: average queue length where early drops start", NULL},
+    {"red-max", PARAM_DOUBLE, offsetof(struct sim, red_max), "red: average queue length where every arrival is dropped", NULL},
+    {"red-maxp", PARAM_DOUBLE, offsetof(struct sim, red_maxp), "red: drop probability just below red-max", NULL},
+    {"red-weight", PARAM_DOUBLE, offsetof(struct sim, red_weight), "red: weight of each arrival in the average queue length", NULL},
+    {"reorder", PARAM_DOUBLE, offsetof(struct sim, reorder), "probability that a packet is held back and overtaken", NULL},
+    {"reorder-depth", PARAM_INT, offsetof(struct sim, reorder_depth), "packets that overtake a held packet", NULL},
+    {"corrupt", PARAM_DOUBLE, offsetof(struct sim, corruptprob), "packet corruption probability", NULL},
+    {"lambda", PARAM_DOUBLE, offsetof(struct sim, lambda), "average time between messages from sender's layer5", NULL},
+    {"window", PARAM_INT, offsetof(struct sim, WINDOW_SIZE), "window size", NULL},
+    {"timeout", PARAM_DOUBLE, offsetof(struct sim, RXMT_TIMEOUT), "retransmission timeout", NULL},
+    {"trace", PARAM_INT, offsetof(struct sim, TRACE), "trace level", NULL},
+    {"seed", PARAM_INT, offsetof(struct sim, seed), "random seed", NULL},
+    {"rng", PARAM_CHOICE, offsetof(struct sim, rng_type), "random number generator: legacy or philox", rng_types},
+    {"sndbuf-max", PARAM_INT, offsetof(struct sim, sndbuf_max), "send buffer cap in slots", NULL},
+    {"backpressure", PARAM_INT, offsetof(struct sim, backpressure), "queue messages when the send buffer is full (0 aborts)", NULL},
+    {"payload", PARAM_INT, offsetof(struct sim, payload_size), "bytes per message and data packet", NULL},
+    {"checksum", PARAM_CHOICE, offsetof(struct sim, checksum_type), "packet checksum: crc32c or sum (the original)", checksum_types},
+    {"verify", PARAM_INT, offsetof(struct sim, verify), "check every delivery against the generated messages (1)", NULL},
+    {"format", PARAM_CHOICE, offsetof(struct sim, STATS_FORMAT), "statistics output: text, json or csv", stats_formats},
+    {"output", PARAM_CHOICE, offsetof(struct sim, OUTPUT_MODE), "OutputFile writes: buffered, mmap or discard", output_modes},
+};
+#define NPARAMS (int)(sizeof(params) / sizeof(params[0]))
+
+void usage(const char *prog)
+{
+  int i;
+  fprintf(stderr, "usage: %s [--config FILE] [--NAME VALUE]...\n", prog);
+  fprintf(stderr, "  with no arguments the parameters are read from stdin\n");
+  fprintf(stderr, "  --config FILE          read NAME = VALUE lines from FILE\n");
+  for (i = 0; i < NPARAMS; i++)
+    fprintf(stderr, "  --%-20s %s\n", params[i].name, params[i].help);
+  exit(1);
+}
+
+/* set the named parameter from its text value; false if either is invalid */
+bool set_param(struct sim *sim, const char *name, const char *text)
+{
+  int i;
+  char *end;
+  for (i = 0; i < NPARAMS; i++)
+  {
+    void *value = (char *)sim + params[i].offset;
+    if (strcmp(params[i].name, name) != 0)
+      continue;
+    if (params[i].type == PARAM_CHOICE)
+    {
+      int c;
+      for (c = 0; params[i].choices[c] != NULL; c++)
+        if (strcmp(params[i].choices[c], text) == 0)
+          break;
+      if (params[i].choices[c] == NULL)
+        return false;
+      *(int *)value = c;
+    }
+    else if (params[i].type == PARAM_INT)
+    {
+      long v = strtol(text, &end, 10);
+      if (end == text || *end != '\0')
+        return false;
+      *(int *)value = (int)v;
+    }
+    else
+    {
+      double v = strtod(text, &end);
+      if (end == text || *end != '\0')
+        return false;
+      *(double *)value = v;
+    }
+    return true;
+  }
+  return false;
+}
+
+/* read "name = value" lines; blank lines and '#' comments are ignored */
+void read_config(struct sim *sim, const char *path)
+{
+  char line[256], name[64], text[64];
+  int lineno = 0;
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr, "cannot open config file %s\n", path);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    char *p = strchr(line, '#');
+    lineno++;
+    if (p != NULL)
+      *p = '\0';
+    for (p = line; *p; p++)
+      if (*p == '=')
+        *p = ' ';
+    if (sscanf(line, "%63s", name) != 1)
+      continue;
+    if (sscanf(line, "%63s %63s", name, text) != 2 || !set_param(sim, name, text))
+    {
+      fprintf(stderr, "%s:%d: invalid parameter line\n", path, lineno);
+      exit(1);
+    }
+  }
+  fclose(f);
+}
+
+void read_stdin_params(struct sim *sim)
+{
+  char protocol[16];
+
+  printf("----- * Network Simulator Version 1.1 * ------ \n\n");
+  printf("Enter number of messages to simulate: ");
+  scanf("%d", &sim->nsimmax);
+  printf("Enter packet loss probability [enter 0.0 for no loss]:");
+  scanf("%lf", &sim->lossprob);
+  printf("Enter packet corruption probability [0.0 for no corruption]:");
+  scanf("%lf", &sim->corruptprob);
+  printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
+  scanf("%lf", &sim->lambda);
+  printf("Enter window size [>0]:");
+  scanf("%d", &sim->WINDOW_SIZE);
+  printf("Enter retransmission timeout [> 0.0]:");
+  scanf("%lf", &sim->RXMT_TIMEOUT);
+  printf("Enter trace level:");
+  scanf("%d", &sim->TRACE);
+  printf("Enter random seed: [>0]:");
+  scanf("%d", &sim->seed[0]);
+  printf("Enter protocol [sr, gbn-sack, gbn]:");
+  if (scanf("%15s", protocol) == 1 && !set_param(sim, "protocol", protocol))
+  {
+    fprintf(stderr, "unknown protocol %s\n", protocol);
+    exit(1);
+  }
+}
+
+/* parse --NAME VALUE / --NAME=VALUE and --config FILE options in order */
+void read_cli_params(struct sim *sim, int argc, char **argv)
+{
+  int i;
+  /* anything not given keeps its sim_create() default */
+  for (i = 1; i < argc; i++)
+  {
+    char name[64];
+    const char *text;
+    const char *eq;
+    if (strncmp(argv[i], "--", 2) != 0 || strcmp(argv[i], "--help") == 0)
+      usage(argv[0]);
+    eq = strchr(argv[i], '=');
+    if (eq != NULL)
+    {
+      snprintf(name, sizeof(name), "%.*s", (int)(eq - argv[i] - 2), argv[i] + 2);
+      text = eq + 1;
+    }
+    else
+    {
+      if (i + 1 >= argc)
+        usage(argv[0]);
+      snprintf(name, sizeof(name), "%s", argv[i] + 2);
+      text = argv[++i];
+    }
+    if (strcmp(name, "config") == 0)
+      read_config(sim, text);
+    else if (!set_param(sim, name, text))
+    {
+      fprintf(stderr, "invalid option --%s %s\n", name, text);
+      usage(argv[0]);
+    }
+  }
+}
+
+void init(struct sim *sim, int argc, char **argv) /* initialize the simulator */
+{
+  if (argc > 1)
+    read_cli_params(sim, argc, argv);
+  else
+    read_stdin_params(sim);
+  output_open(sim, "OutputFile");
+}
+
+/* check the parameters and set up the entities and the first arrival */
+void sim_start(struct sim *sim)
+{
+  int i = 0;
+  if (sim->nsimmax < 0 || sim->WINDOW_SIZE <= 0 || sim->lambda <= 0.0 || sim->RXMT_TIMEOUT <= 0.0 ||
+      sim->payload_size < 2)
+  {
+    fprintf(stderr, "invalid parameters: need messages >= 0, window > 0, lambda > 0, timeout > 0, payload >= 2\n");
+    exit(1);
+  }
+  if (sim->link_model == LINK_BOTTLENECK &&
+      (sim->bandwidth <= 0.0 || sim->prop_delay < 0.0 || sim->queue_size < 1 ||
+       (sim->aqm == AQM_RED && (sim->red_min < 0.0 || sim->red_max <= sim->red_min || sim->red_weight <= 0.0 ||
+                                sim->red_weight > 1.0))))
+  {
+    fprintf(stderr, "invalid link: need bandwidth > 0, prop-delay >= 0, queue >= 1, "
+                    "0 <= red-min < red-max and 0 < red-weight <= 1\n");
+    exit(1);
+  }
+  if (sim->reorder < 0.0 || sim->reorder > 1.0 || sim->reorder_depth < 1)
+  {
+    fprintf(stderr, "invalid reordering: need 0 <= reorder <= 1 and reorder-depth >= 1\n");
+    exit(1);
+  }
+  sim->LIMIT_SEQNO = sim->WINDOW_SIZE * 2; // set appropriately; here assumes SR
+  /* gbn-sack's receiver takes its window start and the 5 seqnums after it,
+     while A may still retransmit up to WINDOW_SIZE packets behind it, so
+     the space needs WINDOW_SIZE + 6 seqnums or an old packet aliases a
+     SACK slot */
+  if (protocols[sim->protocol_index] == &protocol_gbn_sack && sim->LIMIT_SEQNO < sim->WINDOW_SIZE + 6)
+    sim->LIMIT_SEQNO = sim->WINDOW_SIZE + 6;
+  sim->seed_param = sim->seed[0];
+  for (i = 1; i < RNG_STREAMS; i++)
+    sim->seed[i] = sim->seed[0] + i;
+  for (i = 0; i < RNG_STREAMS; i++)
+    sim->rng_next[i] = RNG_BLOCK;
+  sim->ntolayer3 = 0;
+  sim->nlost = 0;
+  sim->ncorrupt = 0;
+  sim->nbursts = 0;
+  sim->nbad = 0;
+  sim->time_now = 0.0; /* initialize time to 0.0 */
+  sim->channel_tail[A] = sim->channel_tail[B] = 0.0;
+  sim->protocol = protocols[sim->protocol_index];
+  if (sim->verify)
+  {
+    sim->verifier.size = sim->nsimmax + 26;
+    sim->verifier.delivered = alloc_or_die(BITMAP_WORDS(sim->verifier.size), sizeof(uint64_t));
+    sim->verifier.highest = -1;
+    sim->verifier.first_divergence = -1;
+  }
+  sim->msgbuf = alloc_or_die(sim->payload_size, 1);
+  sim->arrived_size = sim->nsimmax + 26;
+  sim->arrived = alloc_or_die(BITMAP_WORDS(sim->arrived_size), sizeof(uint64_t));
+  if (sim->link_model == LINK_BOTTLENECK)
+    for (i = 0; i < 2; i++)
+    {
+      sim->link[i].depart = alloc_or_die(sim->queue_size, sizeof(double));
+      sim->link[i].red_count = -1;
+    }
+  sim->crc32c = crc32c_select();
+  A_init(sim);
+  sim->protocol->B_init(sim);
+  sim->B_ent.ack_pkt.payload = NULL; /* ACKs are header only */
+  generate_next_arrival(sim); /* initialize event list */
+}
+
+/****************************************************************************/
+/* mrand(): return a double in range [0,1].  The routine below is used to */
+/* isolate all random number generation in one location.  We assume that the*/
+/* system-supplied rand() function return an int in therange [0,mmm]        */
+/*     modified by Chong Wang on Oct.21,2005                                */
+/****************************************************************************/
+int nextrand(struct sim *sim, int i)
+{
+  sim->seed[i] = sim->seed[i] * 1103515245 + 12345;
+  return (unsigned int)(sim->seed[i] / 65536) % 32768;
+}
+
+/* one Philox4x32-10 block (Salmon et al., SC'11): ten rounds over the
+   counter under the key, leaving the four random words in ctr */
+void philox4x32(uint32_t ctr[4], const uint32_t key[2])
+{
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int r = 0; r < 10; r++)
+  {
+    uint64_t p0 = (uint64_t)0xD2511F53 * ctr[0];
+    uint64_t p1 = (uint64_t)0xCD9E8D57 * ctr[2];
+    uint32_t c0 = (uint32_t)(p1 >> 32) ^ ctr[1] ^ k0;
+    uint32_t c2 = (uint32_t)(p0 >> 32) ^ ctr[3] ^ k1;
+    ctr[0] = c0;
+    ctr[1] = (uint32_t)p1;
+    ctr[2] = c2;
+    ctr[3] = (uint32_t)p0;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+}
+
+/* the next n draws of the LCG seeded with *seed, as nextrand() would
+   give them.  Lane l of lcg runs l steps ahead of lane 0, so advancing
+   all eight lanes by a^8 is one vectorizable multiply-add per lane */
+void lcg_fill(unsigned int *seed, double *out, int n)
+{
+  double mmm = 32767;    /* largest int  - MACHINE DEPENDENT!!!!!!!!   */
+  unsigned int lcg[8], a8 = 1, c8 = 0;
+  int j = 0, l;
+  if (n >= 8)
+  {
+    for (l = 0; l < 8; l++)
+    {
+      *seed = *seed * 1103515245 + 12345;
+      lcg[l] = *seed;
+      a8 *= 1103515245;
+      c8 = c8 * 1103515245 + 12345;
+    }
+    for (;;)
+    {
+      for (l = 0; l < 8; l++)
+        out[j + l] = ((lcg[l] >> 16) & 0x7fff) / mmm;
+      *seed = lcg[7];
+      if ((j += 8) + 8 > n)
+        break;
+      for (l = 0; l < 8; l++)
+        lcg[l] = lcg[l] * a8 + c8;
+    }
+  }
+  for (; j < n; j++)
+  {
+    *seed = *seed * 1103515245 + 12345;
+    out[j] = (*seed / 65536) % 32768 / mmm;
+  }
+}
+
+/* draws 2*block .. 2*block+2*m-1 of Philox stream i; the ten rounds run
+   across PHILOX_LANES consecutive counters at once, so they vectorize */
+#define PHILOX_LANES (RNG_BLOCK / 2)
+void philox_fill(const uint32_t key[2], uint64_t block, int i, double *out, int m)
+{
+  uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+  uint32_t k0 = key[0], k1 = key[1];
+  int l, r;
+  for (l = 0; l < PHILOX_LANES; l++)
+  {
+    c0[l] = (uint32_t)(block + l);
+    c1[l] = (uint32_t)((block + l) >> 32);
+    c2[l] = i;
+    c3[l] = 0;
+  }
+  for (r = 0; r < 10; r++)
+  {
+    for (l = 0; l < PHILOX_LANES; l++)
+    {
+      uint64_t p0 = (uint64_t)0xD2511F53 * c0[l];
+      uint64_t p1 = (uint64_t)0xCD9E8D57 * c2[l];
+      c0[l] = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+      c1[l] = (uint32_t)p1;
+      c2[l] = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+      c3[l] = (uint32_t)p0;
+    }
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  for (l = 0; l < m; l++)
+  {
+    out[2 * l] = (((uint64_t)c0[l] << 32 | c1[l]) >> 11) * 0x1p-53;
+    out[2 * l + 1] = (((uint64_t)c2[l] << 32 | c3[l]) >> 11) * 0x1p-53;
+  }
+}
+
+/* the next n draws of stream i.  The legacy LCG gives multiples of
+   1/32767 in [0,1]; Philox gives 53-bit doubles in [0,1), draw k of
+   stream i being half of block (k/2, i) under the seed, so any stream
+   of any run can be regenerated, or split off, from its counter alone */
+void rng_fill(struct sim *sim, int i, double *out, int n)
+{
+  if (sim->rng_type == RNG_LEGACY)
+  {
+    lcg_fill(&sim->seed[i], out, n);
+    return;
+  }
+  const uint32_t key[2] = {(uint32_t)sim->seed_param, 0};
+  uint32_t *w = sim->rng_block[i];
+  int j = 0;
+  while (j < n)
+  {
+    uint64_t k = sim->rng_draws[i];
+    int m = (n - j) / 2 < PHILOX_LANES ? (n - j) / 2 : PHILOX_LANES;
+    if ((k & 1) == 0 && m > 0)
+    {
+      /* whole blocks */
+      philox_fill(key, k >> 1, i, out + j, m);
+      sim->rng_draws[i] += 2 * m;
+      j += 2 * m;
+      continue;
+    }
+    /* one draw, from the block of an odd draw count or for an odd n */
+    if ((k & 1) == 0)
+    {
+      w[0] = (uint32_t)(k >> 1);
+      w[1] = (uint32_t)(k >> 33);
+      w[2] = i;
+      w[3] = 0;
+      philox4x32(w, key);
+    }
+    uint64_t bits = k & 1 ? (uint64_t)w[2] << 32 | w[3] : (uint64_t)w[0] << 32 | w[1];
+    out[j++] = (bits >> 11) * 0x1p-53;
+    sim->rng_draws[i]++;
+  }
+}
+
+/* a draw from stream i, handed out of a block of RNG_BLOCK filled at once */
+double mrand(struct sim *sim, int i)
+{
+  double x;
+  if (sim->rng_next[i] == RNG_BLOCK)
+  {
+    rng_fill(sim, i, sim->rng_buf[i], RNG_BLOCK);
+    sim->rng_next[i] = 0;
+  }
+  x = sim->rng_buf[i][sim->rng_next[i]++]; /* x should be uniform in [0,1] */
+  LOG(LOG_RAND, "%.16f\n", x);
+  return (x);
+}
+
+/********************* EVENT HANDLINE ROUTINES *******/
+/*  The next set of routines handle the event list   */
+/*****************************************************/
+void generate_next_arrival(struct sim *sim)
+{
+  double x, log(), ceil();
+  struct event *evptr;
+  //   char *malloc(); commented out by matta 10/17/2013
+
+  LOG(LOG_DEBUG, "          GENERATE NEXT ARRIVAL: creating new arrival\n");
+
+  x = sim->lambda * mrand(sim, 0) * 2; /* x is uniform on [0,2*lambda] */
+                             /* having mean of lambda        */
+  evptr = allocevent(sim);
+  evptr->evtime = sim->time_now + x;
+  evptr->evtype = FROM_LAYER5;
+  evptr->eventity = A;
+  insertevent(sim, evptr);
+}
+
+/* true if event a must be simulated before event b */
+static bool evbefore(struct event *a, struct event *b)
+{
+  if (a->evtime != b->evtime)
+    return a->evtime < b->evtime;
+  return a->evseq > b->evseq;
+}
+
+static void evsiftup(struct sim *sim, int i)
+{
+  struct event *p = sim->evlist[i];
+  while (i > 0)
+  {
+    int parent = (i - 1) / 2;
+    if (!evbefore(p, sim->evlist[parent]))
+      break;
+    sim->evlist[i] = sim->evlist[parent];
+    i = parent;
+  }
+  sim->evlist[i] = p;
+}
+
+static void evsiftdown(struct sim *sim, int i)
+{
+  struct event *p = sim->evlist[i];
+  for (;;)
+  {
+    int child = 2 * i + 1;
+    if (child >= sim->evcount)
+      break;
+    if (child + 1 < sim->evcount && evbefore(sim->evlist[child + 1], sim->evlist[child]))
+      child++;
+    if (!evbefore(sim->evlist[child], p))
+      break;
+    sim->evlist[i] = sim->evlist[child];
+    i = child;
+  }
+  sim->evlist[i] = p;
+}
+
+/* remove and return the event at heap position i */
+static struct event *removeevent(struct sim *sim, int i)
+{
+  struct event *p = sim->evlist[i];
+  sim->evcount--;
+  if (i < sim->evcount)
+  {
+    sim->evlist[i] = sim->evlist[sim->evcount];
+    if (i > 0 && evbefore(sim->evlist[i], sim->evlist[(i - 1) / 2]))
+      evsiftup(sim, i);
+    else
+      evsiftdown(sim, i);
+  }
+  return p;
+}
+
+void insertevent(struct sim *sim, struct event *p)
+{
+  LOG(LOG_DEBUG, "            INSERTEVENT: time is %f\n", sim->time_now);
+  LOG(LOG_DEBUG, "            INSERTEVENT: future time will be %f\n", p->evtime);
+  if (sim->evcount == sim->evcapacity)
+  {
+    sim->evcapacity = sim->evcapacity ? sim->evcapacity * 2 : 64;
+    sim->evlist = (struct event **)realloc(sim->evlist, sim->evcapacity * sizeof(struct event *));
+    if (sim->evlist == NULL)
+    {
+      printf("INTERNAL PANIC: out of memory for event list \n");
+      exit(1);
+    }
+  }
+  p->evseq = sim->evseq_next++;
+  p->cancelled = false;
+  sim->evlist[sim->evcount++] = p;
+  evsiftup(sim, sim->evcount - 1);
+}
+
+/* take an event from the pool, growing it by one slab when it runs dry */
+struct event *allocevent(struct sim *sim)
+{
+  struct event *p;
+  int i;
+
+  if (sim->evpool_free == NULL)
+  {
+    struct event *slab = (struct event *)malloc(EVPOOL_SLAB * (sizeof(struct event) + sim->payload_size));
+    if (slab == NULL)
+    {
+      printf("INTERNAL PANIC: out of memory for event pool \n");
+      exit(1);
+    }
+    sim->evpool_slab_list = (struct event **)realloc(sim->evpool_slab_list,
+                                                     (sim->evpool_slabs + 1) * sizeof(struct event *));
+    if (sim->evpool_slab_list == NULL)
+    {
+      printf("INTERNAL PANIC: out of memory for event pool \n");
+      exit(1);
+    }
+    sim->evpool_slab_list[sim->evpool_slabs] = slab;
+    for (i = 0; i < EVPOOL_SLAB; i++)
+    {
+      slab[i].nextfree = i + 1 < EVPOOL_SLAB ? &slab[i + 1] : NULL;
+      slab[i].payload = (char *)(slab + EVPOOL_SLAB) + (size_t)i * sim->payload_size;
+    }
+    sim->evpool_free = slab;
+    sim->evpool_slabs++;
+  }
+  p = sim->evpool_free;
+  sim->evpool_free = p->nextfree;
+  if (++sim->evpool_inuse > sim->evpool_peak)
+    sim->evpool_peak = sim->evpool_inuse;
+  return p;
+}
+
+/* return an event to the pool */
+void freeevent(struct sim *sim, struct event *p)
+{
+  p->nextfree = sim->evpool_free;
+  sim->evpool_free = p;
+  sim->evpool_inuse--;
+}
+
+/* remove and return the earliest event, or NULL if the list is empty */
+struct event *popevent(struct sim *sim)
+{
+  if (sim->evcount == 0)
+    return NULL;
+  return removeevent(sim, 0);
+}
+
+void printevlist(struct sim *sim)
+{
+  int i;
+  printf("--------------\nEvent List Follows (heap order):\n");
+  for (i = 0; i < sim->evcount; i++)
+  {
+    printf("Event time: %f, type: %d entity: %d\n", sim->evlist[i]->evtime, sim->evlist[i]->evtype, sim->evlist[i]->eventity);
+  }
+  printf("--------------\n");
+}
+
+/********************** Student-callable ROUTINES ***********************/
+
+/* called by students routine to cancel a previously-started timer */
+void stoptimer(struct sim *sim, int AorB) /* A or B is trying to stop timer */
+{
+  LOG(LOG_DEBUG, "          STOP TIMER: stopping timer at %f\n", sim->time_now);
+  if (sim->timers[AorB] != NULL)
+  {
+    /* leave the event in the list; the main loop drops it */
+    sim->timers[AorB]->cancelled = true;
+    sim->timers[AorB] = NULL;
+    return;
+  }
+  LOG(LOG_WARN, "Warning: unable to cancel your timer. It wasn't running.\n");
+}
+
+void starttimer(struct sim *sim, int AorB, double increment) /* A or B is trying to stop timer */
+{
+
+  struct event *evptr;
+  // char *malloc(); commented out by matta 10/17/2013
+
+  LOG(LOG_DEBUG, "          START TIMER: starting timer at %f\n", sim->time_now);
+  /* be nice: check to see if timer is already started, if so, then  warn */
+  if (sim->timers[AorB] != NULL)
+  {
+    LOG(LOG_WARN, "Warning: attempt to start a timer that is already started\n");
+    return;
+  }
+
+  /* create future event for when timer goes off */
+  evptr = allocevent(sim);
+  evptr->evtime = sim->time_now + increment;
+  evptr->evtype = TIMER_INTERRUPT;
+  evptr->eventity = AorB;
+  insertevent(sim, evptr);
+  sim->timers[AorB] = evptr;
+}
+
+/************************** TOLAYER3 ***************/
+/* loss probability of the packet A or B is sending.  Under the      */
+/* Gilbert-Elliott model it is that of the state the channel is in,  */
+/* which then moves on by one step of its two-state Markov chain.     */
+double channel_lossprob(struct sim *sim, int AorB)
+{
+  bool bad = sim->ge_bad[AorB];
+  if (sim->loss_model == LOSS_BERNOULLI)
+    return sim->lossprob;
+  if (bad)
+    sim->nbad++;
+  sim->ge_bad[AorB] = mrand(sim, 5) < (bad ? 1.0 - sim->ge_to_good : sim->ge_to_bad);
+  return bad ? sim->ge_loss_bad : sim->ge_loss_good;
+}
+
+/* Reordering: with probability reorder, a packet from A or B is held */
+/* back until reorder_depth later packets from the same side have     */
+/* been scheduled, and then arrives right behind the last of them.   */
+/* Should the sender fall silent first, it arrives reorder_depth * 10 */
+/* after it would have, the longest the random link takes to carry   */
+/* that many packets; so it is scheduled for then at once, and an    */
+/* earlier release cancels that event and schedules a copy.          */
+void channel_reorder(struct sim *sim, int AorB, struct event *evptr)
+{
+  struct event *held = sim->reorder_held[AorB];
+  if (held != NULL && sim->time_now >= sim->reorder_until[AorB])
+    held = sim->reorder_held[AorB] = NULL; /* arrived without being overtaken */
+
+  if (held != NULL)
+  {
+    struct event *copy;
+    if (--sim->reorder_left[AorB] > 0)
+      return;
+    copy = allocevent(sim);
+    copy->evtime = evptr->evtime;
+    copy->evtype = held->evtype;
+    copy->eventity = held->eventity;
+    copy->msgno = held->msgno;
+    copy->pkt = held->pkt;
+    copy->pkt.payload = copy->payload;
+    memcpy(copy->payload, held->payload, sim->payload_size);
+    held->cancelled = true;
+    /* inserted before evptr, so it comes out after it at the same time */
+    insertevent(sim, copy);
+    sim->reorder_held[AorB] = NULL;
+    sim->nreordered++;
+    return;
+  }
+  if (mrand(sim, 7) < sim->reorder)
+  {
+    evptr->evtime += 10.0 * sim->reorder_depth;
+    sim->reorder_held[AorB] = evptr;
+    sim->reorder_until[AorB] = evptr->evtime;
+    sim->reorder_left[AorB] = sim->reorder_depth;
+    sim->nheld++;
+    LOG(LOG_WARN, "          TOLAYER3: packet being held back\n");
+  }
+}
+
+/* count an arrival at B of the data packet with send index msgno (-1  */
+/* for corrupted ones); every intact copy after the first was sent in  */
+/* vain, whichever protocol sent it                                    */
+void note_arrival(struct sim *sim, int msgno)
+{
+  if (msgno < 0 || msgno >= sim->arrived_size)
+    return;
+  if ((sim->arrived[msgno / 64] >> (msgno % 64)) & 1)
+    sim->nspurious++;
+  sim->arrived[msgno / 64] |= (uint64_t)1 << (msgno % 64);
+}
+
+/* packets in B's receive buffer, for protocols that have one */
+int receiver_occupancy(struct sim *sim)
+{
+  int count = 0;
+  for (int i = 0; i < BITMAP_WORDS(sim->B_ent.mask + 1); i++)
+    count += __builtin_popcountll(sim->B_ent.present[i]);
+  return count;
+}
+
+/* queue a packet of size bytes on the link from A or B, setting    */
+/* *arrival to when it reaches the other side; false if it is dropped */
+bool link_send(struct sim *sim, int AorB, int size, double *arrival)
+{
+  struct link *l = &sim->link[AorB];
+  double start, serialization;
+
+  /* packets serialized by now have left the queue */
+  while (l->count > 0 && l->depart[l->head] <= sim->time_now)
+  {
+    l->head = (l->head + 1) % sim->queue_size;
+    l->count--;
+  }
+  if (l->count > l->peak)
+    l->peak = l->count;
+
+  /* Floyd and Jacobson's RED, spacing early drops out by red_count */
+  if (sim->aqm == AQM_RED)
+    l->red_avg += sim->red_weight * (l->count - l->red_avg);
+  if (l->count == sim->queue_size)
+  {
+    l->red_count = 0;
+    l->drops++;
+    return false;
+  }
+  if (sim->aqm == AQM_RED)
+  {
+    if (l->red_avg >= sim->red_max)
+    {
+      l->red_count = 0;
+      l->drops++;
+      return false;
+    }
+    if (l->red_avg >= sim->red_min)
+    {
+      l->red_count++;
+      double pb = sim->red_maxp * (l->red_avg - sim->red_min) / (sim->red_max - sim->red_min);
+      double pa = l->red_count * pb < 1.0 ? pb / (1.0 - l->red_count * pb) : 1.0;
+      if (mrand(sim, 6) < pa)
+      {
+        l->red_count = 0;
+        l->drops++;
+        return false;
+      }
+    }
+    else
+      l->red_count = -1; /* a new congestion episode starts afresh */
+  }
+
+  start = l->count > 0 ? l->depart[(l->head + l->count - 1) % sim->queue_size] : sim->time_now;
+  serialization = size / sim->bandwidth;
+  l->depart[(l->head + l->count++) % sim->queue_size] = start + serialization;
+  l->sent++;
+  l->queue_delay_sum += start - sim->time_now;
+  if (start - sim->time_now > l->queue_delay_max)
+    l->queue_delay_max = start - sim->time_now;
+  l->serialization_sum += serialization;
+  *arrival = start + serialization + sim->prop_delay;
+  return true;
+}
+
+void tolayer3(struct sim *sim, int AorB, struct pkt packet) /* A or B is trying to stop timer */
+{
+  struct pkt *mypktptr;
+  struct event *evptr;
+  // char *malloc(); commented out by matta 10/17/2013
+  double lastime, x, arrival = 0.0;
+  int i;
+  bool lost;
+  int size = HEADER_BYTES + (AorB == A ? sim->payload_size : 0);
+
+  sim->ntolayer3++;
+  sim->nbytes[AorB] += size;
+
+  /* simulate losses: */
+  lost = mrand(sim, 1) < channel_lossprob(sim, AorB);
+  /* a packet lost on the wire still took its turn on the link */
+  if (sim->link_model == LINK_BOTTLENECK && !link_send(sim, AorB, size, &arrival))
+  {
+    LOG(LOG_WARN, "          TOLAYER3: packet dropped by the queue\n");
+    return;
+  }
+  if (lost && !sim->last_lost[AorB])
+    sim->nbursts++;
+  sim->last_lost[AorB] = lost;
+  if (lost)
+  {
+    sim->nlost++;
+    LOG(LOG_WARN, "          TOLAYER3: packet being lost\n");
+    return;
+  }
+
+  /* make a copy of the packet student just gave me since he/she may decide */
+  /* to do something with the packet after we return back to him/her */
+  evptr = allocevent(sim);
+  mypktptr = &evptr->pkt;
+  mypktptr->seqnum = packet.seqnum;
+  mypktptr->acknum = packet.acknum;
+  mypktptr->checksum = packet.checksum;
+  mypktptr->payload = evptr->payload;
+  if (AorB == A)
+    memcpy(mypktptr->payload, packet.payload, sim->payload_size);
+  for (i = 0; i < 5; i++)
+    mypktptr->sack[i] = packet.sack[i];
+  /* A only sends from its window, so the seqnum pins down the send index */
+  evptr->msgno = -1;
+  if (AorB == A)
+    evptr->msgno = sim->A_ent.window_start +
+                   ((packet.seqnum - sim->A_ent.window_start) % sim->LIMIT_SEQNO + sim->LIMIT_SEQNO) % sim->LIMIT_SEQNO;
+  LOG(LOG_DEBUG, "          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum,
+      mypktptr->acknum, mypktptr->checksum);
+
+  /* create future event for arrival of packet at the other side */
+  evptr->evtype = FROM_LAYER3;      /* packet will pop out from layer3 */
+  evptr->eventity = (AorB + 1) % 2; /* event occurs at other entity */
+                                    /* finally, compute the arrival time of packet at the other end.
+                                       the medium itself does not reorder, so make sure packet arrives
+                                       between 1 and 10 time units after the latest arrival time of packets
+                                       currently in the medium on their way to the destination;
+                                       channel_reorder() below may still hold it back */
+  if (sim->link_model == LINK_BOTTLENECK)
+    evptr->evtime = arrival; /* FIFO with a fixed delay, so in order too */
+  else
+  {
+    lastime = sim->time_now;
+    if (sim->channel_tail[evptr->eventity] > lastime)
+      lastime = sim->channel_tail[evptr->eventity];
+    evptr->evtime = lastime + 1 + 9 * mrand(sim, 2);
+  }
+  sim->channel_tail[evptr->eventity] = evptr->evtime;
+
+  /* simulate corruption: */
+  /* modified by Chong Wang on Oct.21, 2005  */
+  if (mrand(sim, 3) < sim->corruptprob)
+  {
+    sim->ncorrupt++;
+    evptr->msgno = -1;
+    if ((x = mrand(sim, 4)) < 0.75)
+    {
+      if (AorB == A)
+        mypktptr->payload[0] = '?'; /* corrupt payload */
+      else
+        mypktptr->acknum = 999999; /* an ACK is all header */
+    }
+    else if (x < 0.875)
+      mypktptr->seqnum = 999999;
+    else
+      mypktptr->acknum = 999999;
+    LOG(LOG_WARN, "          TOLAYER3: packet being corrupted\n");
+  }
+
+  LOG(LOG_DEBUG, "          TOLAYER3: scheduling arrival on other side\n");
+  if (sim->reorder > 0.0)
+    channel_reorder(sim, AorB, evptr);
+  insertevent(sim, evptr);
+}
+
+/************************** LAYER-5 OUTPUT ***************/
+/* Deliveries are copied into outbuf rather than written one */
+/* at a time.  In OUTPUT_BUFFERED mode it is an OUTBUF_SIZE   */
+/* buffer written out whenever it fills; in OUTPUT_MMAP mode  */
+/* it is OutputFile itself, mapped at the size of one message */
+/* per message simulated and grown if the run delivers more.  */
+/* output_close() writes out what is left and trims the file. */
+/*********************************************************/
+#ifndef OUTBUF_SIZE
+#define OUTBUF_SIZE (1 << 20)
+#endif
+
+void output_write(struct sim *sim)
+{
+  size_t done = 0;
+  while (done < sim->outbuf_used)
+  {
+    ssize_t n = write(sim->fileoutput, sim->outbuf + done, sim->outbuf_used - done);
+    if (n <= 0)
+    {
+      printf("INTERNAL PANIC: cannot write OutputFile \n");
+      exit(1);
+    }
+    done += n;
+  }
+  sim->outbuf_used = 0;
+}
+
+/* map OutputFile at size bytes, keeping what is already written; false */
+/* if it cannot be mapped                                               */
+bool output_map(struct sim *sim, size_t size)
+{
+  char *map;
+  if (sim->outbuf != NULL)
+    munmap(sim->outbuf, sim->outbuf_size);
+  sim->outbuf = NULL;
+  if (ftruncate(sim->fileoutput, size) < 0)
+    return false;
+  map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, sim->fileoutput, 0);
+  if (map == MAP_FAILED)
+    return false;
+  sim->outbuf = map;
+  sim->outbuf_size = size;
+  return true;
+}
+
+void output_open(struct sim *sim, const char *path)
+{
+  size_t size = (size_t)(sim->nsimmax > 0 ? sim->nsimmax : 1) * sim->payload_size;
+  if (sim->OUTPUT_MODE == OUTPUT_DISCARD)
+    return;
+  sim->fileoutput = open(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (sim->fileoutput < 0)
+    exit(1);
+  if (sim->OUTPUT_MODE == OUTPUT_MMAP && !output_map(sim, size))
+  {
+    LOG(LOG_WARN, "Warning: cannot map %s, buffering output instead\n", path);
+    if (ftruncate(sim->fileoutput, 0) < 0)
+    {
+      printf("INTERNAL PANIC: cannot truncate OutputFile \n");
+      exit(1);
+    }
+    sim->OUTPUT_MODE = OUTPUT_BUFFERED;
+  }
+}
+
+void output_close(struct sim *sim)
+{
+  if (sim->fileoutput < 0)
+    return;
+  if (sim->OUTPUT_MODE == OUTPUT_MMAP)
+  {
+    if (sim->outbuf != NULL)
+      munmap(sim->outbuf, sim->outbuf_size);
+    /* the mapping ran ahead of the data, so trim the file back to it */
+    if (ftruncate(sim->fileoutput, sim->outbuf_used) < 0)
+    {
+      printf("INTERNAL PANIC: cannot truncate OutputFile \n");
+      exit(1);
+    }
+  }
+  else
+  {
+    output_write(sim);
+    free(sim->outbuf);
+  }
+  sim->outbuf = NULL;
+  close(sim->fileoutput);
+  sim->fileoutput = -1;
+}
+
+void tolayer5(struct sim *sim, char *datasent)
+{
+  if (sim->verify)
+    verify_delivery(&sim->verifier, datasent, sim->payload_size);
+  if (sim->fileoutput < 0)
+    return;
+  if (sim->outbuf_used + sim->payload_size > sim->outbuf_size || sim->outbuf == NULL)
+  {
+    if (sim->OUTPUT_MODE == OUTPUT_MMAP)
+    {
+      if (!output_map(sim, sim->outbuf_size * 2))
+      {
+        printf("INTERNAL PANIC: cannot grow mapped OutputFile \n");
+        exit(1);
+      }
+    }
+    else if (sim->outbuf == NULL)
+    {
+      sim->outbuf_size = OUTBUF_SIZE > sim->payload_size ? OUTBUF_SIZE : sim->payload_size;
+      sim->outbuf = alloc_or_die(sim->outbuf_size, 1);
+    }
+    else
+      output_write(sim);
+  }
+  memcpy(sim->outbuf + sim->outbuf_used, datasent, sim->payload_size);
+  sim->outbuf_used += sim->payload_size;
+}
@@ -0,0 +1,1369 @@
+#include <array>
+#include <bitset>
+#include <vector>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ******************************************************************
+   ARQ NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
+   Modified by Chong Wang on Oct.21,2005 for csa2,csa3 environments
+
+   This code should be used for PA2, unidirectional data transfer protocols
+   (from A to B)
+   Network properties:
+   - one way network delay averages five time units (longer if there
+     are other messages in the channel for Pipelined ARQ), but can be larger
+   - packets can be corrupted (either the header or the data portion)
+     or lost, according to user-defined probabilities
+   - packets will be delivered in the order in which they were sent
+     (although some can be lost).
+
+   FIXED-WINDOW ENGINE
+   The protocols of arq.c, built on the C++ skeleton, with the window
+   size as a template parameter.  For a window size known at compile
+   time the sequence space (twice the window) is a constant, a power of
+   two for the common sizes, so every "% LIMIT_SEQNO" is a mask, the
+   receive buffer is a fixed array, and the loops over the window have
+   constant bounds.  main()
+   dispatches the window size given at run time to one of the common
+   sizes, or to the generic engine (window size 0) for any other.
+**********************************************************************/
+
+/* a "msg" is the data unit passed from layer 5 (teachers code) to layer  */
+/* 4 (students' code).  It contains the data (characters) to be delivered */
+/* to layer 5 via the students transport level protocol entities.         */
+struct msg
+{
+  char data[20];
+};
+
+/* a packet is the data unit passed from layer 4 (students code) to layer */
+/* 3 (teachers code).  Note the pre-defined packet structure, which all   */
+/* students must follow. */
+struct pkt
+{
+  int seqnum;
+  int acknum;
+  int checksum;
+  char payload[20];
+  int sack[5]; /* selectively ACKed seqnums, -1 for none (gbn-sack only) */
+};
+
+/* bytes of seqnum, acknum, checksum and sack[] on the wire; B's ACKs */
+/* are header only, as in arq.c                                       */
+#define HEADER_BYTES (8 * 4)
+
+/*- Your Definitions
+  ---------------------------------------------------------------------------*/
+
+/* Please use the following values in your program */
+
+#define A 0
+#define B 1
+#define FIRST_SEQNO 0
+
+enum Protocol
+{
+  SR,
+  GBN_SACK,
+  GBN
+};
+
+const char *const protocol_names[] = {"sr", "gbn-sack", "gbn", NULL};
+
+#define STATS_TEXT 0
+#define STATS_JSON 1
+#define STATS_CSV 2
+
+const char *const stats_formats[] = {"text", "json", "csv", NULL};
+
+#define OUTPUT_BUFFERED 0 /* OutputFile written through stdio */
+#define OUTPUT_DISCARD 1  /* no OutputFile */
+
+const char *const output_modes[] = {"buffered", "discard", NULL};
+
+/* the run parameters, with their defaults */
+struct Params
+{
+  int protocol = SR;
+  int messages = 1000;
+  double loss = 0.0;
+  double corrupt = 0.0;
+  double lambda = 200.0;
+  int window = 8;
+  double timeout = 30.0;
+  int trace = 0;
+  int seed = 1;
+  int format = STATS_TEXT;
+  int output = OUTPUT_BUFFERED;
+};
+
+constexpr bool is_pow2(int n)
+{
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+constexpr int round_up_pow2(int n)
+{
+  int size = 1;
+  while (size < n)
+    size *= 2;
+  return size;
+}
+
+/*****************************************************************
+***************** NETWORK EMULATION CODE STARTS BELOW ***********
+The code below emulates the layer 3 and below network environment:
+  - emulates the tranmission and delivery (possibly with bit-level corruption
+    and packet loss) of packets across the layer 3/4 interface
+  - handles the starting/stopping of a timer, and generates timer
+    interrupts (resulting in calling students timer handler).
+  - generates message to be sent (passed from later 5 to 4)
+
+It draws from the same random streams, in the same order, as the
+emulator in arq.c with its later options at their defaults, so a run
+with the same parameters and seed produces the same counters and
+OutputFile; arq/check_fixed.sh compares the two.
+******************************************************************/
+
+/* possible events: */
+#define TIMER_INTERRUPT 0
+#define FROM_LAYER5 1
+#define FROM_LAYER3 2
+
+struct event
+{
+  double evtime;       /* event time */
+  int evtype;          /* event type code */
+  int eventity;        /* entity where event occurs */
+  unsigned long evseq; /* insertion order, breaks ties on equal evtime */
+  struct pkt pkt;      /* packet (if any) assoc w/ this event */
+};
+
+
+class Emulator
+{
+public:
+  explicit Emulator(const Params &params);
+  ~Emulator();
+  void Simulation_done();
+
+protected:
+  Params p;
+  double time_now = 0.0;
+
+  // Statistics
+  int num_original_transmitted = 0;
+  int num_retransmissions = 0;
+  int num_delivered = 0;
+  int num_ack_sent = 0;
+  int num_ack_received = 0;
+  int num_corrupted = 0;
+  double rtt_sum = 0;
+  int rtt_count = 0;
+  double comm_time_sum = 0;
+  int comm_time_count = 0;
+  double completion_time_sum = 0;
+  int sndbuf_slots = 0; /* send buffer size, kept by the engine */
+
+  /* event to simulate next, skipping stopped timers; false when done */
+  bool next_event(event &ev);
+  void generate_next_arrival();
+  void starttimer(int AorB, double increment);
+  void stoptimer(int AorB);
+  void tolayer3(int AorB, const pkt &packet);
+  void tolayer5(const char datasent[20]);
+
+private:
+  /* the event list: a binary heap of the ordering keys of events held */
+  /* in a pool, so sifting neither copies packets nor chases pointers  */
+  struct evkey
+  {
+    double evtime;
+    unsigned long evseq;
+    int index; /* in evpool */
+  };
+  std::vector<event> evpool;
+  std::vector<int> evpool_free;
+  std::vector<evkey> evlist;
+  unsigned long evseq_next = 0;
+  /* evseq + 1 of each entity's pending timer event, 0 if not running; */
+  /* a stopped timer stays queued and is dropped when it comes up      */
+  unsigned long timers[2] = {0, 0};
+  /* latest arrival time scheduled by tolayer3() towards each entity */
+  double channel_tail[2] = {0.0, 0.0};
+  int ntolayer3 = 0; /* number sent into layer 3 */
+  int nlost = 0;     /* number lost in media */
+  int ncorrupt = 0;  /* number corrupted by media*/
+  long nbytes[2] = {0, 0}; /* bytes sent into layer 3 by A and by B */
+  int nbursts = 0;   /* runs of consecutive losses in one direction */
+  bool last_lost[2] = {false, false}; /* whether the last packet A or B sent was lost */
+  int nsim = 0;
+  unsigned int seed[5]; /* seed used in the pseudo-random generator */
+  FILE *fileoutput;
+
+  double mrand(int i);
+  static bool evbefore(const evkey &a, const evkey &b);
+  int allocevent();
+  void insertevent(int index);
+  void stats(const char *name, const char *value, bool &first, bool header);
+};
+
+Emulator::Emulator(const Params &params) : p(params)
+{
+  for (int i = 0; i < 5; i++)
+    seed[i] = p.seed + i;
+  fileoutput = NULL;
+  if (p.output == OUTPUT_BUFFERED && (fileoutput = fopen("OutputFile", "w")) == NULL)
+    exit(1);
+  generate_next_arrival(); /* initialize event list */
+}
+
+Emulator::~Emulator()
+{
+  if (fileoutput)
+    fclose(fileoutput);
+}
+
+/* mrand(): return a double in range [0,1], from random stream i */
+double Emulator::mrand(int i)
+{
+  seed[i] = seed[i] * 1103515245 + 12345;
+  return (unsigned int)(seed[i] / 65536) % 32768 / 32767.0;
+}
+
+/* true if event a must be simulated before event b; equal times pop */
+/* most-recently-inserted first, as in arq.c                         */
+bool Emulator::evbefore(const evkey &a, const evkey &b)
+{
+  if (a.evtime != b.evtime)
+    return a.evtime < b.evtime;
+  return a.evseq > b.evseq;
+}
+
+/* index of an unused event in the pool, taken off the free list; fill */
+/* in evpool[index] and pass the index to insertevent()                */
+int Emulator::allocevent()
+{
+  if (evpool_free.empty())
+  {
+    evpool.emplace_back();
+    return evpool.size() - 1;
+  }
+  int index = evpool_free.back();
+  evpool_free.pop_back();
+  return index;
+}
+
+void Emulator::insertevent(int index)
+{
+  event &ev = evpool[index];
+  ev.evseq = evseq_next++;
+  evkey key = {ev.evtime, ev.evseq, index};
+  /* sift up from a new leaf */
+  int i = evlist.size();
+  evlist.push_back(key);
+  while (i > 0 && evbefore(key, evlist[(i - 1) / 2]))
+  {
+    evlist[i] = evlist[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  evlist[i] = key;
+}
+
+bool Emulator::next_event(event &ev)
+{
+  while (!evlist.empty())
+  {
+    ev = evpool[evlist[0].index];
+    evpool_free.push_back(evlist[0].index);
+    /* sift the last leaf down from the root */
+    evkey last = evlist.back();
+    evlist.pop_back();
+    int i = 0, n = evlist.size();
+    for (;;)
+    {
+      int child = 2 * i + 1;
+      if (child >= n)
+        break;
+      if (child + 1 < n && evbefore(evlist[child + 1], evlist[child]))
+        child++;
+      if (!evbefore(evlist[child], last))
+        break;
+      evlist[i] = evlist[child];
+      i = child;
+    }
+    if (n > 0)
+      evlist[i] = last;
+    if (ev.evtype == TIMER_INTERRUPT)
+    {
+      if (timers[ev.eventity] != ev.evseq + 1)
+        continue;
+      timers[ev.eventity] = 0;
+    }
+    time_now = ev.evtime; /* update time to next event time */
+    if (ev.evtype != FROM_LAYER5)
+      return true;
+    generate_next_arrival(); /* set up future arrival */
+    /* fill in msg to give with string of same letter */
+    for (int i = 0; i < 20; i++)
+      ev.pkt.payload[i] = 97 + nsim % 26;
+    ev.pkt.payload[19] = '\n';
+    nsim++;
+    return nsim != p.messages + 1;
+  }
+  return false;
+}
+
+void Emulator::generate_next_arrival()
+{
+  int index = allocevent();
+  event &ev = evpool[index];
+  ev.evtime = time_now + p.lambda * mrand(0) * 2; /* uniform on [0,2*lambda] */
+  ev.evtype = FROM_LAYER5;
+  ev.eventity = A;
+  insertevent(index);
+}
+
+void Emulator::stoptimer(int AorB)
+{
+  if (timers[AorB] != 0)
+  {
+    timers[AorB] = 0;
+    return;
+  }
+  if (p.trace >= 1)
+    printf("Warning: unable to cancel your timer. It wasn't running.\n");
+}
+
+void Emulator::starttimer(int AorB, double increment)
+{
+  if (timers[AorB] != 0)
+  {
+    if (p.trace >= 1)
+      printf("Warning: attempt to start a timer that is already started\n");
+    return;
+  }
+  int index = allocevent();
+  event &ev = evpool[index];
+  ev.evtime = time_now + increment;
+  ev.evtype = TIMER_INTERRUPT;
+  ev.eventity = AorB;
+  insertevent(index);
+  timers[AorB] = ev.evseq + 1;
+}
+
+void Emulator::tolayer3(int AorB, const pkt &packet)
+{
+  ntolayer3++;
+  nbytes[AorB] += HEADER_BYTES + (AorB == A ? 20 : 0);
+
+  /* simulate losses: */
+  bool lost = mrand(1) < p.loss;
+  if (lost && !last_lost[AorB])
+    nbursts++;
+  last_lost[AorB] = lost;
+  if (lost)
+  {
+    nlost++;
+    if (p.trace >= 1)
+      printf("          TOLAYER3: packet being lost\n");
+    return;
+  }
+
+  int index = allocevent();
+  event &ev = evpool[index];
+  ev.pkt = packet;
+  ev.evtype = FROM_LAYER3;      /* packet will pop out from layer3 */
+  ev.eventity = (AorB + 1) % 2; /* event occurs at other entity */
+  /* the medium can not reorder: arrive 1 to 10 time units after the */
+  /* latest arrival already scheduled towards the same entity        */
+  double lastime = time_now;
+  if (channel_tail[ev.eventity] > lastime)
+    lastime = channel_tail[ev.eventity];
+  ev.evtime = lastime + 1 + 9 * mrand(2);
+  channel_tail[ev.eventity] = ev.evtime;
+
+  /* simulate corruption: */
+  if (mrand(3) < p.corrupt)
+  {
+    double x;
+    ncorrupt++;
+    if ((x = mrand(4)) < 0.75)
+      ev.pkt.payload[0] = '?'; /* corrupt payload */
+    else if (x < 0.875)
+      ev.pkt.seqnum = 999999;
+    else
+      ev.pkt.acknum = 999999;
+    if (p.trace >= 1)
+      printf("          TOLAYER3: packet being corrupted\n");
+  }
+  insertevent(index);
+}
+
+void Emulator::tolayer5(const char datasent[20])
+{
+  if (fileoutput)
+    fwrite(datasent, 1, 20, fileoutput);
+}
+
+/* one field of the statistics record, as a CSV header or value column */
+/* or a JSON member; NULL values are numbers that have no JSON form    */
+void Emulator::stats(const char *name, const char *value, bool &first, bool header)
+{
+  const char *sep = first ? "" : p.format == STATS_JSON ? ", " : ",";
+  first = false;
+  if (p.format == STATS_JSON)
+    printf("%s\"%s\": %s", sep, name, value ? value : "null");
+  else
+    printf("%s%s", sep, header ? name : value ? value : "");
+}
+
+/* called at end of simulation to print final statistics */
+void Emulator::Simulation_done()
+{
+  double lost_ratio = (double)(num_retransmissions - num_corrupted) /
+                      (num_original_transmitted + num_retransmissions + num_ack_sent);
+  double corrupted_ratio = (double)num_corrupted /
+                           (num_original_transmitted + num_retransmissions + num_ack_sent - (num_retransmissions - num_corrupted));
+
+  if (p.format != STATS_TEXT)
+  {
+    /* the same columns as arq's record, so both simulators can share a
+       sweep; a text field is a string, and the distributions and
+       duplicate counts this engine does not keep are NAN and print as
+       null (JSON) or empty (CSV) */
+    struct
+    {
+      const char *name;
+      bool is_int;
+      double value;
+      const char *text = NULL; /* set for string fields */
+    } fields[] = {
+        {"simulator", false, 0, "arq_fixed"},
+        {"protocol", false, 0, protocol_names[p.protocol]},
+        {"messages", true, (double)p.messages},
+        {"loss", false, p.loss},
+        {"corrupt", false, p.corrupt},
+        {"lambda", false, p.lambda},
+        {"window", true, (double)p.window},
+        {"timeout", false, p.timeout},
+        {"seed", true, (double)p.seed},
+        {"payload", true, 20},
+        {"original_transmitted", true, (double)num_original_transmitted},
+        {"retransmissions", true, (double)num_retransmissions},
+        {"delivered", true, (double)num_delivered},
+        {"acks_sent", true, (double)num_ack_sent},
+        {"acks_received", true, (double)num_ack_received},
+        {"corrupted", true, (double)num_corrupted},
+        {"lost_ratio", false, lost_ratio},
+        {"corrupted_ratio", false, corrupted_ratio},
+        {"avg_rtt", false, rtt_sum / rtt_count},
+        {"rtt_count", true, (double)rtt_count},
+        {"avg_comm_time", false, comm_time_sum / comm_time_count},
+        {"comm_time_count", true, (double)comm_time_count},
+        {"avg_completion_time", false, completion_time_sum / comm_time_count},
+        {"rtt_p50", false, NAN},
+        {"rtt_p90", false, NAN},
+        {"rtt_p99", false, NAN},
+        {"rtt_p999", false, NAN},
+        {"rtt_max", false, NAN},
+        {"e2e_delay_p50", false, NAN},
+        {"e2e_delay_p90", false, NAN},
+        {"e2e_delay_p99", false, NAN},
+        {"e2e_delay_p999", false, NAN},
+        {"e2e_delay_max", false, NAN},
+        {"retx_p50", false, NAN},
+        {"retx_p90", false, NAN},
+        {"retx_p99", false, NAN},
+        {"retx_p999", false, NAN},
+        {"retx_max", false, NAN},
+        {"sndbuf_slots", true, (double)sndbuf_slots},
+        /* the send buffer grows without a cap, so nothing is backlogged */
+        {"backlogged", true, 0},
+        {"backlog_peak", true, 0},
+        {"avg_backlog_delay", false, 0},
+        {"max_backlog_delay", false, 0},
+        {"delivered_bytes", true, num_delivered * 20.0},
+        {"bytes_sent_a", true, (double)nbytes[A]},
+        {"bytes_sent_b", true, (double)nbytes[B]},
+        {"goodput", false, num_delivered * 20.0 / time_now},
+        /* Bernoulli loss over a random-delay channel without reordering:
+           the loss-model, reordering and link columns read as arq's do
+           for those settings */
+        {"loss_bursts", true, (double)nbursts},
+        {"ge_to_bad", false, NAN},
+        {"ge_to_good", false, NAN},
+        {"ge_loss_good", false, NAN},
+        {"ge_loss_bad", false, NAN},
+        {"ge_bad_packets", true, 0},
+        {"spurious_retransmissions", true, NAN},
+        {"rcvbuf_p50", false, NAN},
+        {"rcvbuf_p90", false, NAN},
+        {"rcvbuf_p99", false, NAN},
+        {"rcvbuf_p999", false, NAN},
+        {"rcvbuf_max", false, NAN},
+        {"reorder", false, 0},
+        {"reorder_depth", true, NAN},
+        {"channel_held", true, 0},
+        {"channel_reordered", true, 0},
+        {"link", false, 0, "random"},
+        {"bandwidth", false, NAN},
+        {"prop_delay", false, NAN},
+        {"queue", true, 0},
+        {"aqm", false, 0, ""},
+        {"red_min", false, NAN},
+        {"red_max", false, NAN},
+        {"red_maxp", false, NAN},
+        {"red_weight", false, NAN},
+        {"queue_drops_a", true, 0},
+        {"queue_drops_b", true, 0},
+        {"queue_peak_a", true, 0},
+        {"queue_peak_b", true, 0},
+        {"avg_queue_delay_a", false, 0},
+        {"avg_queue_delay_b", false, 0},
+        {"max_queue_delay_a", false, 0},
+        {"max_queue_delay_b", false, 0},
+        {"avg_serialization_a", false, 0},
+        {"avg_serialization_b", false, 0},
+        {"to_layer3", true, (double)ntolayer3},
+        {"channel_lost", true, (double)nlost},
+        {"channel_corrupted", true, (double)ncorrupt},
+        {"sim_time", false, time_now},
+        {"event_pool_peak", true, (double)evpool.size()},
+    };
+    bool first = true;
+    if (p.format == STATS_JSON)
+      printf("{");
+    else
+    {
+      for (auto &f : fields)
+        stats(f.name, NULL, first, true);
+      printf("\n");
+      first = true;
+    }
+    for (auto &f : fields)
+    {
+      char text[40];
+      const char *value = text;
+      if (f.text)
+        snprintf(text, sizeof(text), p.format == STATS_JSON ? "\"%s\"" : "%s", f.text);
+      else if (!isfinite(f.value))
+        value = NULL;
+      else if (f.is_int)
+        snprintf(text, sizeof(text), "%ld", (long)f.value);
+      else
+      {
+        /* shortest of 15 or 17 digits that reads back as the same value */
+        snprintf(text, sizeof(text), "%.15g", f.value);
+        if (strtod(text, NULL) != f.value)
+          snprintf(text, sizeof(text), "%.17g", f.value);
+      }
+      stats(f.name, value, first, false);
+    }
+    printf(p.format == STATS_JSON ? "}\n" : "\n");
+    return;
+  }
+
+  /* TO PRINT THE STATISTICS, FILL IN THE DETAILS BY PUTTING VARIBALE NAMES. DO NOT CHANGE THE FORMAT OF PRINTED OUTPUT */
+  printf("\n\n===============STATISTICS======================= \n\n");
+  printf("Number of original packets transmitted by A: %d \n", num_original_transmitted);
+  printf("Number of retransmissions by A: %d \n", num_retransmissions);
+  printf("Number of data packets delivered to layer 5 at B: %d \n", num_delivered);
+  printf("Number of ACK packets sent by B: %d \n", num_ack_sent);
+  printf("Number of corrupted packets: %d \n", num_corrupted);
+  printf("Ratio of lost packets: %.3f \n", lost_ratio);
+  printf("Ratio of corrupted packets: %.3f \n", corrupted_ratio);
+  printf("Average RTT: %.3f \n", rtt_sum / rtt_count);
+  printf("Average communication time: %.3f \n", comm_time_sum / comm_time_count);
+  printf("==================================================");
+
+  /* PRINT YOUR OWN STATISTIC HERE TO CHECK THE CORRECTNESS OF YOUR PROGRAM */
+  printf("\nEXTRA: \n");
+  printf("Number of ACK packets received by A: %d \n", num_ack_received);
+  printf("Total RTT: %.3f \n", rtt_sum);
+  printf("Number of RTT measurements: %d \n", rtt_count);
+  printf("Total communication time: %.3f \n", comm_time_sum);
+  printf("Number of communication time measurements: %d \n", comm_time_count);
+  printf("Average completion time (layer 5 to final ACK): %.3f \n", completion_time_sum / comm_time_count);
+  printf("Simulator terminated at time %.12f\n", time_now);
+}
+
+/********* THE PROTOCOL ENGINE *********/
+/* Engine<P, W> runs protocol P with a window of W packets, or of     */
+/* p.window packets when W is 0.  The routines mirror those of arq.c, */
+/* with sr_, gbn_sack_ and gbn_ prefixes for the protocol-specific    */
+/* ones, and the emulator calls them through A_input, B_input and     */
+/* A_timerinterrupt, which pick the protocol at compile time.         */
+
+struct send_times
+{
+  double submitted;  /* taken from layer 5 */
+  double first_sent; /* first handed to layer 3 */
+};
+
+/* B's buffer of out-of-order packets: window slots rounded up to a power */
+/* of two, as a fixed array when the window size is a constant            */
+template <int W>
+struct ReceiveBuffer
+{
+  static constexpr int mask = round_up_pow2(W) - 1;
+  std::array<pkt, mask + 1> packet_buffer;
+  std::bitset<mask + 1> present;
+  ReceiveBuffer(int) {}
+};
+
+template <>
+struct ReceiveBuffer<0>
+{
+  int mask;
+  std::vector<pkt> packet_buffer;
+  std::vector<bool> present;
+  ReceiveBuffer(int window)
+      : mask(round_up_pow2(window) - 1), packet_buffer(mask + 1), present(mask + 1) {}
+};
+
+template <Protocol P, int W>
+class Engine : public Emulator
+{
+public:
+  explicit Engine(const Params &params) : Emulator(params), B_buf(params.window)
+  {
+    A_init();
+    B_init();
+  }
+  void simulate();
+
+private:
+  // Window size and sequence space; constants when W is not 0.  As in
+  // arq.c, gbn-sack needs at least W + 6 seqnums, since B takes the five
+  // after its window start as SACKs
+  static constexpr int limit_for(int w) { return P == GBN_SACK && w < 6 ? w + 6 : 2 * w; }
+  static constexpr int LIMIT = limit_for(W);
+  int window_size() const { return W ? W : p.window; }
+  int limit() const { return W ? LIMIT : limit_for(p.window); }
+  int seqno(int i) const
+  {
+    if constexpr (is_pow2(LIMIT))
+      return i & (LIMIT - 1);
+    else if constexpr (W > 0)
+      return i % LIMIT;
+    else
+      return i % limit();
+  }
+
+  // Sender: a ring of packets taken from layer 5, grown on demand, with
+  // absolute indices window_start <= send_next <= buffer_next
+  struct Sender
+  {
+    int window_start;
+    int send_next;
+    int buffer_next;
+    int last_ack;
+    int mask;
+    std::vector<pkt> packet_buffer;
+    std::vector<bool> present;
+    std::vector<send_times> times;
+    std::vector<int> retransmissions;
+  } A_ent;
+
+  struct Receiver
+  {
+    int window_start;
+    pkt ack_pkt;
+  } B_ent;
+  ReceiveBuffer<W> B_buf;
+
+  static int get_checksum(const pkt &packet);
+  void A_init();
+  void B_init();
+  void A_output(const msg &message);
+  void A_input(const pkt &ack_packet);
+  void A_timerinterrupt();
+  void B_input(const pkt &packet);
+  bool ack_in_window(int acknum) const;
+  void grow_send_buffer();
+  void send_window();
+  void send_ack();
+  void restart_rxmt_timer();
+  void record_time_measurement(int i);
+
+  void sr_A_input(const pkt &ack_packet);
+  void sr_A_timerinterrupt();
+  void sr_B_input(const pkt &packet);
+  void retransmit_first_outstanding_packet();
+  void deliver_subseq_data();
+  void gbn_sack_A_input(const pkt &ack_packet);
+  void gbn_sack_A_timerinterrupt();
+  void gbn_sack_B_input(const pkt &packet);
+  bool insert_sack(const pkt &packet);
+  void gbn_A_input(const pkt &ack_packet);
+  void gbn_A_timerinterrupt();
+  void gbn_B_input(const pkt &packet);
+};
+
+/********* ROUTINES SHARED BY ALL PROTOCOLS *********/
+
+template <Protocol P, int W>
+int Engine<P, W>::get_checksum(const pkt &packet)
+{
+  int checksum = packet.seqnum + packet.acknum;
+  for (int i = 0; i < 20; i++)
+    checksum += packet.payload[i];
+  return checksum;
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::A_init()
+{
+  A_ent.window_start = FIRST_SEQNO;
+  A_ent.send_next = FIRST_SEQNO;
+  A_ent.buffer_next = FIRST_SEQNO;
+  A_ent.last_ack = -1;
+  A_ent.mask = round_up_pow2(window_size() > 64 ? window_size() : 64) - 1;
+  A_ent.packet_buffer.assign(A_ent.mask + 1, pkt{});
+  A_ent.present.assign(A_ent.mask + 1, false);
+  A_ent.times.assign(A_ent.mask + 1, send_times{});
+  A_ent.retransmissions.assign(A_ent.mask + 1, 0);
+  sndbuf_slots = A_ent.mask + 1;
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::B_init()
+{
+  B_ent.window_start = FIRST_SEQNO;
+  B_ent.ack_pkt = pkt{};
+  B_ent.ack_pkt.seqnum = -1;
+  for (int i = 0; i < 5; i++)
+    B_ent.ack_pkt.sack[i] = -1;
+}
+
+/* true if an ACK for acknum names a send index in [window_start,
+   send_next]; as in arq.c, stale ACKs must not move the window */
+template <Protocol P, int W>
+bool Engine<P, W>::ack_in_window(int acknum) const
+{
+  int d = ((acknum - A_ent.window_start) % limit() + limit()) % limit();
+  return acknum >= 0 && acknum < limit() && d <= A_ent.send_next - A_ent.window_start;
+}
+
+/* double the send buffer, re-homing the buffered packets */
+template <Protocol P, int W>
+void Engine<P, W>::grow_send_buffer()
+{
+  Sender &s = A_ent;
+  int mask = (s.mask + 1) * 2 - 1;
+  std::vector<pkt> packet_buffer(mask + 1);
+  std::vector<bool> present(mask + 1);
+  std::vector<send_times> times(mask + 1);
+  std::vector<int> retransmissions(mask + 1);
+  for (int i = s.window_start; i < s.buffer_next; i++)
+  {
+    if (!s.present[i & s.mask])
+      continue;
+    packet_buffer[i & mask] = s.packet_buffer[i & s.mask];
+    times[i & mask] = s.times[i & s.mask];
+    retransmissions[i & mask] = s.retransmissions[i & s.mask];
+    present[i & mask] = true;
+  }
+  s.packet_buffer.swap(packet_buffer);
+  s.present.swap(present);
+  s.times.swap(times);
+  s.retransmissions.swap(retransmissions);
+  s.mask = mask;
+  sndbuf_slots = mask + 1;
+}
+
+/* called from layer 5, passed the data to be sent to other side */
+template <Protocol P, int W>
+void Engine<P, W>::A_output(const msg &message)
+{
+  if (A_ent.buffer_next - A_ent.window_start > A_ent.mask)
+    grow_send_buffer();
+  pkt *packet = &A_ent.packet_buffer[A_ent.buffer_next & A_ent.mask];
+  packet->seqnum = seqno(A_ent.buffer_next);
+  memcpy(packet->payload, message.data, 20);
+  packet->checksum = get_checksum(*packet);
+  A_ent.times[A_ent.buffer_next & A_ent.mask].submitted = time_now;
+  A_ent.present[A_ent.buffer_next & A_ent.mask] = true;
+  A_ent.buffer_next++;
+  send_window();
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::send_window()
+{
+  if (A_ent.send_next == A_ent.buffer_next || A_ent.send_next == A_ent.window_start + window_size())
+    return;
+
+  restart_rxmt_timer();
+
+  while (A_ent.send_next < A_ent.buffer_next && A_ent.send_next < A_ent.window_start + window_size())
+  {
+    A_ent.times[A_ent.send_next & A_ent.mask].first_sent = time_now;
+    tolayer3(A, A_ent.packet_buffer[A_ent.send_next & A_ent.mask]);
+    num_original_transmitted++;
+    A_ent.send_next++;
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::send_ack()
+{
+  B_ent.ack_pkt.acknum = seqno(B_ent.window_start);
+  B_ent.ack_pkt.checksum = get_checksum(B_ent.ack_pkt);
+  tolayer3(B, B_ent.ack_pkt);
+  num_ack_sent++;
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::restart_rxmt_timer()
+{
+  stoptimer(A);
+  starttimer(A, p.timeout);
+}
+
+/* communication time, RTT (Karn's rule) and completion time of packet i, */
+/* as in arq.c                                                            */
+template <Protocol P, int W>
+void Engine<P, W>::record_time_measurement(int i)
+{
+  send_times &times = A_ent.times[i & A_ent.mask];
+  double measurement_time = time_now - times.first_sent;
+
+  comm_time_sum += measurement_time;
+  comm_time_count++;
+  if (A_ent.retransmissions[i & A_ent.mask] == 0)
+  {
+    rtt_sum += measurement_time;
+    rtt_count++;
+  }
+  A_ent.retransmissions[i & A_ent.mask] = 0;
+  completion_time_sum += time_now - times.submitted;
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::A_input(const pkt &ack_packet)
+{
+  if constexpr (P == SR)
+    sr_A_input(ack_packet);
+  else if constexpr (P == GBN_SACK)
+    gbn_sack_A_input(ack_packet);
+  else
+    gbn_A_input(ack_packet);
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::A_timerinterrupt()
+{
+  if constexpr (P == SR)
+    sr_A_timerinterrupt();
+  else if constexpr (P == GBN_SACK)
+    gbn_sack_A_timerinterrupt();
+  else
+    gbn_A_timerinterrupt();
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::B_input(const pkt &packet)
+{
+  if constexpr (P == SR)
+    sr_B_input(packet);
+  else if constexpr (P == GBN_SACK)
+    gbn_sack_B_input(packet);
+  else
+    gbn_B_input(packet);
+}
+
+/* simulate until the event list runs dry or the last message is generated */
+template <Protocol P, int W>
+void Engine<P, W>::simulate()
+{
+  event ev;
+  while (next_event(ev))
+  {
+    if (ev.evtype == FROM_LAYER5)
+    {
+      msg message;
+      memcpy(message.data, ev.pkt.payload, 20);
+      A_output(message);
+    }
+    else if (ev.evtype == FROM_LAYER3)
+    {
+      if (ev.eventity == A)
+        A_input(ev.pkt);
+      else
+        B_input(ev.pkt);
+    }
+    else
+      A_timerinterrupt();
+  }
+}
+
+/********* SELECTIVE REPEAT WITH CUMULATIVE ACKS *********/
+
+template <Protocol P, int W>
+void Engine<P, W>::retransmit_first_outstanding_packet()
+{
+  int i = A_ent.window_start;
+  while (i < A_ent.send_next && !A_ent.present[i & A_ent.mask])
+    i++;
+  if (A_ent.present[i & A_ent.mask])
+  {
+    A_ent.retransmissions[i & A_ent.mask]++;
+    num_retransmissions++;
+    restart_rxmt_timer();
+    tolayer3(A, A_ent.packet_buffer[i & A_ent.mask]);
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::sr_A_input(const pkt &ack_packet)
+{
+  num_ack_received++;
+  if (ack_packet.checksum != get_checksum(ack_packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  if (!ack_in_window(ack_packet.acknum))
+    return;
+
+  if (ack_packet.acknum == A_ent.last_ack)
+    retransmit_first_outstanding_packet();
+  A_ent.last_ack = ack_packet.acknum;
+
+  // Move window forward
+  int i = A_ent.window_start;
+  for (; i < A_ent.send_next && seqno(i) != ack_packet.acknum; i++)
+  {
+    A_ent.present[i & A_ent.mask] = false;
+    record_time_measurement(i);
+  }
+  if (i > A_ent.window_start)
+  {
+    A_ent.window_start = i;
+    send_window();
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::sr_A_timerinterrupt()
+{
+  if (A_ent.window_start != A_ent.send_next)
+    retransmit_first_outstanding_packet();
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::deliver_subseq_data()
+{
+  // Deliver subsequent data packets waiting in the buffer
+  while (B_buf.present[B_ent.window_start & B_buf.mask])
+  {
+    tolayer5(B_buf.packet_buffer[B_ent.window_start & B_buf.mask].payload);
+    num_delivered++;
+    B_buf.present[B_ent.window_start & B_buf.mask] = false;
+    B_ent.window_start++;
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::sr_B_input(const pkt &packet)
+{
+  if (packet.checksum != get_checksum(packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  if (seqno(B_ent.window_start) == packet.seqnum) // In-order packet
+  {
+    tolayer5(packet.payload);
+    num_delivered++;
+    B_ent.window_start++;
+    deliver_subseq_data();
+  }
+  else // Out-of-order packet
+  {
+    // Find position of received packet in buffer; with a constant
+    // window size this loop has constant bounds
+    int i = B_ent.window_start + 1;
+    while (i < B_ent.window_start + window_size() && seqno(i) != packet.seqnum)
+      i++;
+    if (i >= B_ent.window_start + window_size())
+    {
+      send_ack();
+      return;
+    }
+    if (B_buf.present[i & B_buf.mask]) // duplicate
+      return;
+    pkt &buf_packet = B_buf.packet_buffer[i & B_buf.mask];
+    buf_packet.seqnum = packet.seqnum;
+    memcpy(buf_packet.payload, packet.payload, 20);
+    B_buf.present[i & B_buf.mask] = true;
+  }
+
+  // Send ACK for expected packet
+  send_ack();
+}
+
+/********* GO-BACK-N WITH SELECTIVE ACKS *********/
+
+template <Protocol P, int W>
+bool Engine<P, W>::insert_sack(const pkt &packet)
+{
+  int sack_start = B_ent.window_start + 1;
+  for (int i = 0; i < 5; i++)
+  {
+    if (seqno(sack_start + i) == packet.seqnum)
+    {
+      if (B_ent.ack_pkt.sack[i] >= 0)
+        return false;
+      tolayer5(packet.payload);
+      num_delivered++;
+      B_ent.ack_pkt.sack[i] = packet.seqnum;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_sack_A_input(const pkt &ack_packet)
+{
+  num_ack_received++;
+  if (ack_packet.checksum != get_checksum(ack_packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  if (!ack_in_window(ack_packet.acknum))
+    return;
+
+  if (ack_packet.acknum == seqno(A_ent.window_start))
+  {
+    // process SACKs
+    for (int i = 0, j = A_ent.window_start + 1; i < 5 && j < A_ent.send_next; i++, j++)
+    {
+      if (ack_packet.sack[i] >= 0 && A_ent.present[j & A_ent.mask])
+      {
+        A_ent.present[j & A_ent.mask] = false;
+        record_time_measurement(j);
+      }
+    }
+    return;
+  }
+
+  // Move window forward
+  int i = A_ent.window_start;
+  for (; i < A_ent.send_next && seqno(i) != ack_packet.acknum; i++)
+  {
+    if (A_ent.present[i & A_ent.mask])
+    {
+      A_ent.present[i & A_ent.mask] = false;
+      record_time_measurement(i);
+    }
+  }
+  A_ent.window_start = i;
+  if (A_ent.window_start == A_ent.send_next) // Send any new packets waiting in the buffer
+    send_window();
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_sack_A_timerinterrupt()
+{
+  if (A_ent.window_start == A_ent.send_next)
+    return;
+  starttimer(A, p.timeout);
+  for (int i = A_ent.window_start; i < A_ent.send_next; i++)
+  {
+    if (A_ent.present[i & A_ent.mask])
+    {
+      tolayer3(A, A_ent.packet_buffer[i & A_ent.mask]);
+      A_ent.retransmissions[i & A_ent.mask]++;
+      num_retransmissions++;
+    }
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_sack_B_input(const pkt &packet)
+{
+  if (packet.checksum != get_checksum(packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  if (packet.seqnum != seqno(B_ent.window_start))
+    insert_sack(packet);
+  else
+  {
+    tolayer5(packet.payload);
+    num_delivered++;
+    int offset = 1;
+    while (offset <= 5 && B_ent.ack_pkt.sack[offset - 1] >= 0)
+      offset++;
+    B_ent.window_start += offset;
+    for (int i = 0; i < 5; i++) // shift SACK
+      B_ent.ack_pkt.sack[i] = i + offset < 5 ? B_ent.ack_pkt.sack[i + offset] : -1;
+  }
+
+  send_ack();
+}
+
+/********* GO-BACK-N *********/
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_A_input(const pkt &ack_packet)
+{
+  num_ack_received++;
+  if (ack_packet.checksum != get_checksum(ack_packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  // Everything before the acknum has arrived; a duplicate ACK moves nothing
+  int i = A_ent.window_start;
+  while (i < A_ent.send_next && seqno(i) != ack_packet.acknum)
+    i++;
+  if (seqno(i) != ack_packet.acknum || i == A_ent.window_start)
+    return;
+  for (int j = A_ent.window_start; j < i; j++)
+  {
+    A_ent.present[j & A_ent.mask] = false;
+    record_time_measurement(j);
+  }
+  A_ent.window_start = i;
+  if (i < A_ent.send_next)
+    restart_rxmt_timer();
+  send_window();
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_A_timerinterrupt()
+{
+  if (A_ent.window_start == A_ent.send_next)
+    return;
+  starttimer(A, p.timeout);
+  for (int i = A_ent.window_start; i < A_ent.send_next; i++)
+  {
+    tolayer3(A, A_ent.packet_buffer[i & A_ent.mask]);
+    A_ent.retransmissions[i & A_ent.mask]++;
+    num_retransmissions++;
+  }
+}
+
+template <Protocol P, int W>
+void Engine<P, W>::gbn_B_input(const pkt &packet)
+{
+  if (packet.checksum != get_checksum(packet))
+  {
+    num_corrupted++;
+    return;
+  }
+
+  if (packet.seqnum == seqno(B_ent.window_start))
+  {
+    tolayer5(packet.payload);
+    num_delivered++;
+    B_ent.window_start++;
+  }
+
+  send_ack();
+}
+
+/********************* RUNTIME DISPATCH *******/
+/* one engine per protocol and common window size; any other window */
+/* size runs on the generic engine                                  */
+
+template <Protocol P, int W>
+void run(const Params &params)
+{
+  Engine<P, W> engine(params);
+  engine.simulate();
+  engine.Simulation_done();
+}
+
+template <Protocol P>
+void run_window(const Params &params)
+{
+  switch (params.window)
+  {
+  case 1: run<P, 1>(params); break;
+  case 2: run<P, 2>(params); break;
+  case 4: run<P, 4>(params); break;
+  case 8: run<P, 8>(params); break;
+  case 16: run<P, 16>(params); break;
+  case 32: run<P, 32>(params); break;
+  case 64: run<P, 64>(params); break;
+  case 128: run<P, 128>(params); break;
+  default: run<P, 0>(params); break;
+  }
+}
+
+/*********************** PARAMETERS ******************/
+
+#define PARAM_INT 0
+#define PARAM_DOUBLE 1
+#define PARAM_CHOICE 2 /* int index into choices */
+
+struct param
+{
+  const char *name;
+  int type;
+  size_t offset; /* of the value in struct Params */
+  const char *help;
+  const char *const *choices;
+};
+
+const struct param params[] = {
+    {"protocol", PARAM_CHOICE, offsetof(Params, protocol), "sr, gbn-sack or gbn", protocol_names},
+    {"messages", PARAM_INT, offsetof(Params, messages), "number of messages to simulate", NULL},
+    {"loss", PARAM_DOUBLE, offsetof(Params, loss), "packet loss probability", NULL},
+    {"corrupt", PARAM_DOUBLE, offsetof(Params, corrupt), "packet corruption probability", NULL},
+    {"lambda", PARAM_DOUBLE, offsetof(Params, lambda), "average time between messages from sender's layer5", NULL},
+    {"window", PARAM_INT, offsetof(Params, window), "window size", NULL},
+    {"timeout", PARAM_DOUBLE, offsetof(Params, timeout), "retransmission timeout", NULL},
+    {"trace", PARAM_INT, offsetof(Params, trace), "trace level (1 prints the emulator warnings)", NULL},
+    {"seed", PARAM_INT, offsetof(Params, seed), "random seed", NULL},
+    {"format", PARAM_CHOICE, offsetof(Params, format), "statistics output: text, json or csv", stats_formats},
+    {"output", PARAM_CHOICE, offsetof(Params, output), "OutputFile writes: buffered or discard", output_modes},
+};
+#define NPARAMS (int)(sizeof(params) / sizeof(params[0]))
+
+void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [--NAME VALUE]...\n", prog);
+  fprintf(stderr, "  with no arguments the parameters are read from stdin\n");
+  for (int i = 0; i < NPARAMS; i++)
+    fprintf(stderr, "  --%-20s %s\n", params[i].name, params[i].help);
+  exit(1);
+}
+
+/* set the named parameter from its text value; false if either is invalid */
+bool set_param(Params *run, const char *name, const char *text)
+{
+  char *end;
+  for (int i = 0; i < NPARAMS; i++)
+  {
+    void *value = (char *)run + params[i].offset;
+    if (strcmp(params[i].name, name) != 0)
+      continue;
+    if (params[i].type == PARAM_CHOICE)
+    {
+      int c;
+      for (c = 0; params[i].choices[c] != NULL; c++)
+        if (strcmp(params[i].choices[c], text) == 0)
+          break;
+      if (params[i].choices[c] == NULL)
+        return false;
+      *(int *)value = c;
+    }
+    else if (params[i].type == PARAM_INT)
+    {
+      long v = strtol(text, &end, 10);
+      if (end == text || *end != '\0')
+        return false;
+      *(int *)value = (int)v;
+    }
+    else
+    {
+      double v = strtod(text, &end);
+      if (end == text || *end != '\0')
+        return false;
+      *(double *)value = v;
+    }
+    return true;
+  }
+  return false;
+}
+
+void read_stdin_params(Params *run)
+{
+  char protocol[16];
+
+  printf("----- * Network Simulator Version 1.1 * ------ \n\n");
+  printf("Enter number of messages to simulate: ");
+  scanf("%d", &run->messages);
+  printf("Enter packet loss probability [enter 0.0 for no loss]:");
+  scanf("%lf", &run->loss);
+  printf("Enter packet corruption probability [0.0 for no corruption]:");
+  scanf("%lf", &run->corrupt);
+  printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
+  scanf("%lf", &run->lambda);
+  printf("Enter window size [>0]:");
+  scanf("%d", &run->window);
+  printf("Enter retransmission timeout [> 0.0]:");
+  scanf("%lf", &run->timeout);
+  printf("Enter trace level:");
+  scanf("%d", &run->trace);
+  printf("Enter random seed: [>0]:");
+  scanf("%d", &run->seed);
+  printf("Enter protocol [sr, gbn-sack, gbn]:");
+  if (scanf("%15s", protocol) == 1 && !set_param(run, "protocol", protocol))
+  {
+    fprintf(stderr, "unknown protocol %s\n", protocol);
+    exit(1);
+  }
+}
+
+/* parse --NAME VALUE / --NAME=VALUE options in order */
+void read_cli_params(Params *run, int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    char name[64];
+    const char *text;
+    const char *eq;
+    if (strncmp(argv[i], "--", 2) != 0 || strcmp(argv[i], "--help") == 0)
+      usage(argv[0]);
+    eq = strchr(argv[i], '=');
+    if (eq != NULL)
+    {
+      snprintf(name, sizeof(name), "%.*s", (int)(eq - argv[i] - 2), argv[i] + 2);
+      text = eq + 1;
+    }
+    else
+    {
+      if (i + 1 >= argc)
+        usage(argv[0]);
+      snprintf(name, sizeof(name), "%s", argv[i] + 2);
+      text = argv[++i];
+    }
+    if (!set_param(run, name, text))
+    {
+      fprintf(stderr, "invalid option --%s %s\n", name, text);
+      usage(argv[0]);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Params run;
+
+  if (argc > 1)
+    read_cli_params(&run, argc, argv);
+  else
+    read_stdin_params(&run);
+  if (run.messages < 0 || run.window <= 0 || run.lambda <= 0.0 || run.timeout <= 0.0)
+  {
+    fprintf(stderr, "invalid parameters: need messages >= 0, window > 0, lambda > 0, timeout > 0\n");
+    exit(1);
+  }
+
+  if (run.protocol == SR)
+    run_window<SR>(run);
+  else if (run.protocol == GBN_SACK)
+    run_window<GBN_SACK>(run);
+  else
+    run_window<GBN>(run);
+  return 0;
+}
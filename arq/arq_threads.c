@@ -0,0 +1,87 @@
+#include <errno.h>
+#include <pthread.h>
+
+/* ******************************************************************
+   IN-PROCESS RUNNER
+
+   Runs several simulations at once in one process, each on its own
+   thread with its own struct sim, to check that the emulator keeps no
+   state outside struct sim.  Each line of stdin holds one run's
+   --NAME VALUE options, as arq takes them; run n (counting lines from
+   1) writes OutputFile.n, and once every run has finished their
+   records or statistics banners are printed in input order.  A run
+   given the same options by arq prints the same record and writes the
+   same OutputFile; arq/check_threads.sh compares the two.
+**********************************************************************/
+
+#define NO_MAIN
+#include "arq.c"
+
+#define MAX_RUNS 64
+#define MAX_ARGS 128
+
+void *run_sim(void *arg)
+{
+  struct sim *sim = arg;
+  sim_start(sim);
+  sim_run(sim);
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  struct sim *sims[MAX_RUNS];
+  pthread_t threads[MAX_RUNS];
+  char line[4096];
+  int nruns = 0;
+  int i;
+
+  if (argc > 1)
+  {
+    fprintf(stderr, "usage: %s < RUNS\n  each line of RUNS holds one run's --NAME VALUE options\n", argv[0]);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), stdin) != NULL)
+  {
+    char *args[MAX_ARGS];
+    char path[32];
+    int nargs = 0;
+    args[nargs++] = argv[0];
+    for (char *tok = strtok(line, " \t\n"); tok != NULL; tok = strtok(NULL, " \t\n"))
+    {
+      if (nargs == MAX_ARGS)
+      {
+        fprintf(stderr, "run %d: more than %d options\n", nruns + 1, MAX_ARGS - 1);
+        exit(1);
+      }
+      args[nargs++] = tok;
+    }
+    if (nargs == 1)
+      continue;
+    if (nruns == MAX_RUNS)
+    {
+      fprintf(stderr, "at most %d runs\n", MAX_RUNS);
+      exit(1);
+    }
+    sims[nruns] = sim_create();
+    read_cli_params(sims[nruns], nargs, args);
+    snprintf(path, sizeof(path), "OutputFile.%d", nruns + 1);
+    output_open(sims[nruns], path);
+    nruns++;
+  }
+
+  for (i = 0; i < nruns; i++)
+    if ((errno = pthread_create(&threads[i], NULL, run_sim, sims[i])) != 0)
+    {
+      perror("pthread_create");
+      exit(1);
+    }
+  for (i = 0; i < nruns; i++)
+    pthread_join(threads[i], NULL);
+  for (i = 0; i < nruns; i++)
+  {
+    Simulation_done(sims[i]);
+    sim_destroy(sims[i]);
+  }
+  return 0;
+}
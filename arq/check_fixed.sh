@@ -0,0 +1,46 @@
+#!/bin/sh
+# Runs arq and arq_fixed on a grid of the configurations both support and
+# compares their OutputFiles and records.  Columns arq_fixed leaves empty
+# are skipped, as is event_pool_peak, which counts each engine's own pool.
+# usage: check_fixed.sh [ARQ] [ARQ_FIXED]
+arq=$(realpath "${1:-arq/arq}")
+fixed=$(realpath "${2:-arq/arq_fixed}")
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+cd "$dir" || exit 1
+runs=0
+failed=0
+for protocol in sr gbn-sack gbn; do
+  for window in 1 3 4 6 8 13 16; do
+    for args in "--loss 0.2 --corrupt 0.2 --lambda 15 --seed 1" \
+                "--loss 0.1 --corrupt 0.05 --lambda 4 --seed 7" \
+                "--corrupt 0.3 --lambda 50 --timeout 15 --seed 3"; do
+      set -- --protocol $protocol --window $window --messages 400 $args --format csv
+      runs=$((runs + 1))
+      "$arq" "$@" > arq.csv && mv OutputFile arq.out &&
+        "$fixed" "$@" > fixed.csv && mv OutputFile fixed.out || {
+        echo "failed to run: $*"
+        failed=$((failed + 1))
+        continue
+      }
+      diff=$(awk -F, '
+        FNR == 1 { header[FILENAME] = $0; next }
+        FILENAME == ARGV[1] { n = split(header[FILENAME], name); for (i = 1; i <= n; i++) want[name[i]] = $i; next }
+        {
+          n = split(header[FILENAME], name)
+          for (i = 1; i <= n; i++)
+            if ($i != "" && name[i] != "simulator" && name[i] != "event_pool_peak" && $i != want[name[i]])
+              printf " %s=%s/%s", name[i], want[name[i]], $i
+        }' arq.csv fixed.csv)
+      if ! cmp -s arq.out fixed.out; then
+        diff="$diff OutputFile"
+      fi
+      if [ -n "$diff" ]; then
+        echo "differs:$diff: $*"
+        failed=$((failed + 1))
+      fi
+    done
+  done
+done
+echo "$runs configurations, $failed differ"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Runs a mix of configurations concurrently in one process with
+# arq_threads, then one at a time with arq, and compares each run's
+# record and OutputFile.
+# usage: check_threads.sh [ARQ] [ARQ_THREADS]
+arq=$(realpath "${1:-arq/arq}")
+threads=$(realpath "${2:-arq/arq_threads}")
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+cd "$dir" || exit 1
+for protocol in sr gbn-sack gbn; do
+  for args in "--loss 0.2 --corrupt 0.2 --lambda 15 --window 4 --seed 1" \
+              "--loss-model gilbert --corrupt 0.1 --lambda 10 --payload 64 --seed 2" \
+              "--link bottleneck --aqm red --lambda 2 --window 16 --rng philox --seed 3" \
+              "--reorder 0.2 --loss 0.1 --lambda 5 --verify 1 --checksum sum --seed 4" \
+              "--loss 0.3 --lambda 1 --window 32 --messages 3000 --output mmap --seed 5"; do
+    echo "--protocol $protocol --messages 500 $args --format json"
+  done
+done > runs
+"$threads" < runs > threads.json || exit 1
+runs=0
+failed=0
+while read -r line; do
+  runs=$((runs + 1))
+  # shellcheck disable=SC2086
+  "$arq" $line > arq.json || exit 1
+  if ! sed -n "${runs}p" threads.json | cmp -s - arq.json; then
+    echo "record differs: $line"
+    failed=$((failed + 1))
+  elif ! cmp -s "OutputFile.$runs" OutputFile; then
+    echo "OutputFile differs: $line"
+    failed=$((failed + 1))
+  fi
+done < runs
+echo "$runs concurrent runs, $failed differ"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,386 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ******************************************************************
+   PARAMETER SWEEP RUNNER
+
+   Runs a simulator (arq/arq) once for every point in a
+   grid of parameter values, on as many worker threads as there are
+   cores, and writes every run's statistics record to one CSV file.
+
+   Each worker owns a deque of grid points: it takes work from the back
+   of its own deque and, once that is empty, steals from the front of
+   another worker's, so slow runs (high loss, small windows) on one
+   worker do not leave the others idle.  Each run is a child process
+   started in its own scratch directory with --output discard, so no
+   simulator spends time writing an OutputFile nobody reads.
+**********************************************************************/
+
+#define MAX_SIMS 8
+
+/* a grid axis: one simulator option and the values it takes */
+struct axis
+{
+  const char *name;
+  const char *help;
+  int count;
+  char **values;
+};
+
+/* in grid order: the last axis varies fastest, after the --sim programs */
+struct axis axes[] = {
+    {"protocol", "ARQ protocol: sr, gbn-sack or gbn", 0, NULL},
+    {"loss", "packet loss probability", 0, NULL},
+    {"loss-model", "loss model: bernoulli or gilbert", 0, NULL},
+    {"ge-to-bad", "gilbert: good to bad transition probability", 0, NULL},
+    {"ge-to-good", "gilbert: bad to good transition probability", 0, NULL},
+    {"ge-loss-good", "gilbert: loss probability in the good state", 0, NULL},
+    {"ge-loss-bad", "gilbert: loss probability in the bad state", 0, NULL},
+    {"link", "packet delay: random or bottleneck", 0, NULL},
+    {"bandwidth", "bottleneck: bytes per time unit", 0, NULL},
+    {"prop-delay", "bottleneck: propagation delay", 0, NULL},
+    {"queue", "bottleneck: queue capacity in packets", 0, NULL},
+    {"aqm", "bottleneck queue management: droptail or red", 0, NULL},
+    {"reorder", "probability that a packet is held back", 0, NULL},
+    {"reorder-depth", "packets that overtake a held packet", 0, NULL},
+    {"corrupt", "packet corruption probability", 0, NULL},
+    {"window", "window size", 0, NULL},
+    {"timeout", "retransmission timeout", 0, NULL},
+    {"messages", "number of messages to simulate", 0, NULL},
+    {"lambda", "average time between messages from layer 5", 0, NULL},
+    {"payload", "bytes per message and data packet", 0, NULL},
+    {"seed", "random seed", 0, NULL},
+};
+#define NAXES ((int)(sizeof(axes) / sizeof(axes[0])))
+
+/* grid point i of the sweep, with results filled in by the worker */
+struct run
+{
+  int sim;
+  char *header; /* CSV header line printed by the simulator */
+  char *record; /* CSV record line printed by the simulator */
+  int status;   /* wait status, or -1 if the run could not be started */
+};
+
+/* work-stealing deque of run indices; the owner pops at bottom, thieves at top */
+struct deque
+{
+  pthread_mutex_t lock;
+  int top;
+  int bottom;
+  int *runs;
+};
+
+const char *sims[MAX_SIMS];
+char sim_paths[MAX_SIMS][PATH_MAX];
+int nsims = 0;
+int njobs = 0;
+struct run *runs;
+int nruns;
+struct deque *deques;
+int nworkers;
+
+void usage(const char *prog)
+{
+  int a;
+  fprintf(stderr, "usage: %s --sim PROGRAM [--sim PROGRAM ...] [--jobs N] [--output FILE] [--AXIS VALUES ...]\n", prog);
+  fprintf(stderr, "  VALUES is a comma-separated list, and each item may be a range START:STOP[:STEP]\n");
+  for (a = 0; a < NAXES; a++)
+    fprintf(stderr, "  --%-13s %s\n", axes[a].name, axes[a].help);
+  exit(1);
+}
+
+/* append a value to the axis, formatted the way the simulator parses it */
+void add_value(struct axis *axis, const char *text)
+{
+  axis->values = realloc(axis->values, (axis->count + 1) * sizeof(char *));
+  if (axis->values == NULL)
+  {
+    printf("out of memory\n");
+    exit(1);
+  }
+  axis->values[axis->count++] = strdup(text);
+}
+
+/* parse "v1,v2,start:stop:step,..." into the axis values */
+void parse_values(struct axis *axis, const char *list, const char *prog)
+{
+  char *copy = strdup(list);
+  char *save = NULL;
+  char *item;
+  axis->count = 0;
+  for (item = strtok_r(copy, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save))
+  {
+    double start, stop, step = 1.0;
+    char text[64];
+    int n, i;
+    if (strchr(item, ':') == NULL)
+    {
+      add_value(axis, item);
+      continue;
+    }
+    if (sscanf(item, "%lf:%lf:%lf", &start, &stop, &step) < 2 || step <= 0.0 || stop < start)
+    {
+      fprintf(stderr, "invalid range --%s %s\n", axis->name, item);
+      usage(prog);
+    }
+    /* count the points first so floating point steps do not drift */
+    n = (int)((stop - start) / step + 1e-9) + 1;
+    for (i = 0; i < n; i++)
+    {
+      snprintf(text, sizeof(text), "%.15g", start + i * step);
+      add_value(axis, text);
+    }
+  }
+  free(copy);
+  if (axis->count == 0)
+  {
+    fprintf(stderr, "no values for --%s\n", axis->name);
+    usage(prog);
+  }
+}
+
+void read_args(int argc, char **argv)
+{
+  int i, a;
+  for (i = 1; i < argc; i++)
+  {
+    const char *name = argv[i];
+    const char *text;
+    if (strncmp(name, "--", 2) != 0 || strcmp(name, "--help") == 0 || i + 1 >= argc)
+      usage(argv[0]);
+    name += 2;
+    text = argv[++i];
+    if (strcmp(name, "sim") == 0)
+    {
+      if (nsims == MAX_SIMS)
+        usage(argv[0]);
+      sims[nsims++] = text;
+      continue;
+    }
+    if (strcmp(name, "jobs") == 0)
+    {
+      njobs = atoi(text);
+      continue;
+    }
+    if (strcmp(name, "output") == 0)
+    {
+      if (freopen(text, "w", stdout) == NULL)
+      {
+        perror(text);
+        exit(1);
+      }
+      continue;
+    }
+    for (a = 0; a < NAXES; a++)
+      if (strcmp(name, axes[a].name) == 0)
+        break;
+    if (a == NAXES)
+    {
+      fprintf(stderr, "unknown option --%s\n", name);
+      usage(argv[0]);
+    }
+    parse_values(&axes[a], text, argv[0]);
+  }
+  if (nsims == 0)
+    usage(argv[0]);
+}
+
+/* read one line from the pipe without its newline, or NULL at end of file */
+char *read_line(FILE *in)
+{
+  char *line = NULL;
+  size_t size = 0;
+  ssize_t len = getline(&line, &size, in);
+  if (len < 0)
+  {
+    free(line);
+    return NULL;
+  }
+  if (len > 0 && line[len - 1] == '\n')
+    line[len - 1] = '\0';
+  return line;
+}
+
+/* run grid point r in the scratch directory dir, collecting its CSV record */
+void execute(int r, const char *dir)
+{
+  char *argv[4 + 2 * NAXES + 3];
+  char flags[NAXES][16];
+  int argc = 0;
+  int rest = r / nsims;
+  int a, fd[2];
+  pid_t pid;
+  FILE *in;
+
+  runs[r].sim = r % nsims;
+  argv[argc++] = sim_paths[runs[r].sim];
+  for (a = NAXES - 1; a >= 0; a--)
+  {
+    if (axes[a].count == 0)
+      continue;
+    snprintf(flags[a], sizeof(flags[a]), "--%s", axes[a].name);
+    argv[argc++] = flags[a];
+    argv[argc++] = axes[a].values[rest % axes[a].count];
+    rest /= axes[a].count;
+  }
+  argv[argc++] = "--format";
+  argv[argc++] = "csv";
+  argv[argc++] = "--output"; /* the sweep only keeps the record */
+  argv[argc++] = "discard";
+  argv[argc] = NULL;
+
+  runs[r].status = -1;
+  /* close-on-exec, so runs started by other workers do not hold this pipe open */
+  if (pipe2(fd, O_CLOEXEC) < 0)
+    return;
+  pid = fork();
+  if (pid < 0)
+  {
+    close(fd[0]);
+    close(fd[1]);
+    return;
+  }
+  if (pid == 0)
+  {
+    dup2(fd[1], STDOUT_FILENO);
+    close(fd[0]);
+    close(fd[1]);
+    if (chdir(dir) == 0)
+      execv(argv[0], argv);
+    _exit(127);
+  }
+  close(fd[1]);
+  in = fdopen(fd[0], "r");
+  runs[r].header = read_line(in);
+  runs[r].record = read_line(in);
+  while (fgetc(in) != EOF)
+    ;
+  fclose(in);
+  while (waitpid(pid, &runs[r].status, 0) < 0 && errno == EINTR)
+    ;
+}
+
+/* next run for worker w: its own newest, else the oldest of another worker */
+int take_run(int w)
+{
+  int v, r = -1;
+  pthread_mutex_lock(&deques[w].lock);
+  if (deques[w].bottom > deques[w].top)
+    r = deques[w].runs[--deques[w].bottom];
+  pthread_mutex_unlock(&deques[w].lock);
+  for (v = 1; r < 0 && v < nworkers; v++)
+  {
+    struct deque *victim = &deques[(w + v) % nworkers];
+    pthread_mutex_lock(&victim->lock);
+    if (victim->bottom > victim->top)
+      r = victim->runs[victim->top++];
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return r;
+}
+
+void *worker(void *arg)
+{
+  int w = (int)(long)arg;
+  char dir[] = "/tmp/sweepXXXXXX";
+  char output[sizeof(dir) + 16];
+  int r;
+  if (mkdtemp(dir) == NULL)
+  {
+    perror("mkdtemp");
+    exit(1);
+  }
+  while ((r = take_run(w)) >= 0)
+    execute(r, dir);
+  snprintf(output, sizeof(output), "%s/OutputFile", dir);
+  unlink(output);
+  rmdir(dir);
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  pthread_t *threads;
+  int i, a, w, failed = 0;
+  const char *header = NULL;
+
+  read_args(argc, argv);
+  for (i = 0; i < nsims; i++)
+    if (realpath(sims[i], sim_paths[i]) == NULL)
+    {
+      perror(sims[i]);
+      exit(1);
+    }
+
+  nruns = nsims;
+  for (a = 0; a < NAXES; a++)
+    if (axes[a].count > 0)
+      nruns *= axes[a].count;
+  runs = calloc(nruns, sizeof(struct run));
+
+  nworkers = njobs > 0 ? njobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nworkers < 1)
+    nworkers = 1;
+  if (nworkers > nruns)
+    nworkers = nruns;
+  deques = calloc(nworkers, sizeof(struct deque));
+  threads = calloc(nworkers, sizeof(pthread_t));
+  if (runs == NULL || deques == NULL || threads == NULL)
+  {
+    printf("out of memory\n");
+    exit(1);
+  }
+
+  /* deal the grid out in contiguous blocks so neighbouring points share a worker */
+  for (w = 0; w < nworkers; w++)
+  {
+    int first = (long)nruns * w / nworkers;
+    int last = (long)nruns * (w + 1) / nworkers;
+    pthread_mutex_init(&deques[w].lock, NULL);
+    deques[w].runs = malloc((last - first) * sizeof(int));
+    for (i = first; i < last; i++)
+      deques[w].runs[deques[w].bottom++] = last - 1 - (i - first);
+  }
+  for (w = 0; w < nworkers; w++)
+    pthread_create(&threads[w], NULL, worker, (void *)(long)w);
+  for (w = 0; w < nworkers; w++)
+    pthread_join(threads[w], NULL);
+
+  /* write the records in grid order under the first header */
+  for (i = 0; i < nruns; i++)
+  {
+    struct run *run = &runs[i];
+    if (run->status != 0 || run->record == NULL)
+    {
+      fprintf(stderr, "run %d of %s failed (status %d)\n", i, sims[run->sim], run->status);
+      failed++;
+      continue;
+    }
+    if (header == NULL)
+    {
+      header = run->header;
+      printf("%s\n", header);
+    }
+    else if (strcmp(header, run->header) != 0)
+    {
+      fprintf(stderr, "run %d of %s has different columns, skipped\n", i, sims[run->sim]);
+      failed++;
+      continue;
+    }
+    printf("%s\n", run->record);
+  }
+  fflush(stdout);
+  fprintf(stderr, "%d runs on %d workers, %d failed\n", nruns, nworkers, failed);
+  return failed ? 1 : 0;
+}